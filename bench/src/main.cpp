@@ -0,0 +1,760 @@
+#include "ofMain.h"
+#include "DepthThreshold.h"
+#include "BlobFinder.h"
+#include "FingertipDetector.h"
+#include "TouchTracker.h"
+#include "RayLUT.h"
+#include "HeightMap.h"
+#include "InteractionZone.h"
+#include "ReplayDepthSource.h"
+#include "CalibrateCoords.h"
+#include "TouchPipeline.h"
+#include "FrameGate.h"
+#include "TuioSender.h"
+#include "TuioReceiver.h"
+#include "ofxOpenCv.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// Headless timing of each touch pipeline stage, no window and no Kinect.
+//
+//   kinect2touch_bench [recording.k2td] [--iterations N] [--out results.json] [--check-allocs]
+//                      [--hands N] [--threads N] [--scale N] [--check-tuio]
+//                      [--check-gate] [--check-small-blob]
+//
+// Without a recording a synthetic hand moving over a table is used, or --hands of them.
+// --scale upsamples the fixture N times in each direction, for higher resolution sensors.
+// Every stage runs N times over the fixture frames (the calibration solve N / 100 times). The results
+// go to stdout as a table and to the --out file (kinect2touch_bench.json by default)
+// as JSON, one stage per line so runs from two builds diff cleanly.
+// The pipeline stage is a whole TouchPipeline frame, with per-blob work spread over
+// --threads threads (0 = one per core, the default); with --check-allocs the run fails
+// if it allocates once warmed up. The tiled_<n>t stages are threshold and labelling in bands
+// on 1, 2, 4... threads up to one per core, for the speedup over a single thread.
+// The band, band_scalar and cv_and stages are the 8-bit threshold, its scalar reference and the
+// two cvThreshold and cvAnd path it replaced, on the fixture mapped to 8 bits as the Kinect does.
+// contour_cv is the ofxCvContourFinder call BlobFinder replaced, beside contour.
+// --check-tuio first sends a frame of known touches to 127.0.0.1 through TuioSender, reads it
+// back with TuioReceiver and fails the run if the ids, positions or fseq don't match.
+// --check-gate fails the run if the frame gate calls the synthetic scene with a few edge pixels
+// flickering between hand and table depth changed, or misses one fingertip pressing down or
+// the hand moving.
+// --check-small-blob fails the run if a blob too small for a k-curvature fingertip, inside the
+// zone, doesn't come out of a whole TouchPipeline frame as a touch.
+
+// every allocation in the process, for allocations per frame
+static std::atomic<uint64_t> allocations(0);
+
+void * operator new(size_t size){
+    allocations++;
+    void * p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void * p) noexcept{
+    free(p);
+}
+
+struct Fixture {
+    string name;
+    int width = 640;
+    int height = 480;
+    float zeroPlanePixelSize = 0.1042;
+    float zeroPlaneDistance = 120;
+    vector<ofShortPixels> frames;
+    float tableZ = 900;     // mm, flat table facing the camera
+};
+
+// the kinect's 8-bit mapping, near = white
+unsigned char toDepth8(unsigned short mm){
+    return mm == 0 ? 0 : ofMap(mm, 500, 4000, 255, 0, true);
+}
+
+// serves the fixture to a TouchPipeline, a new frame on every update()
+class FixtureDepthSource : public DepthSource {
+public:
+
+    FixtureDepthSource(const Fixture & fixture) : fixture(fixture) {}
+
+    bool open(){ return true; }
+    void close(){}
+
+    void update(){
+        const ofShortPixels & frame = fixture.frames[frameNum % fixture.frames.size()];
+        rawDepth.setFromPixels(frame.getData(), fixture.width, fixture.height, OF_PIXELS_GRAY);
+
+        depth.allocate(fixture.width, fixture.height, OF_PIXELS_GRAY);
+        for (size_t i=0; i<(size_t)fixture.width * fixture.height; i++)
+            depth[i] = toDepth8(rawDepth[i]);
+
+        frameNum++;
+    }
+
+    bool isConnected(){ return true; }
+    bool isFrameNew(){ return true; }
+
+    int getWidth(){ return fixture.width; }
+    int getHeight(){ return fixture.height; }
+
+    ofPixels & getDepthPixels(){ return depth; }
+    ofShortPixels & getRawDepthPixels(){ return rawDepth; }
+    ofPixels & getPixels(){ return color; }
+
+    uint64_t getFrameTimestamp(){ return frameNum * 33333; }
+
+    float getZeroPlanePixelSize(){ return fixture.zeroPlanePixelSize; }
+    float getZeroPlaneDistance(){ return fixture.zeroPlaneDistance; }
+
+    ofVec3f getWorldCoordinateAt(int x, int y){ return ofVec3f(); }
+    ofVec3f getWorldCoordinateAt(float cx, float cy, float wz){ return ofVec3f(); }
+
+private:
+
+    const Fixture & fixture;
+    uint64_t frameNum = 0;
+    ofPixels depth;
+    ofShortPixels rawDepth;
+    ofPixels color;     // no RGB in the fixtures
+
+};
+
+struct Result {
+    string stage;
+    int iterations;
+    double nsPerFrame;
+    double allocsPerFrame;
+};
+
+//--------------------------------------------------------------
+bool loadFixture(string path, Fixture & fixture){
+
+    ReplayDepthSource replay;
+    replay.bRealtime = false;
+    replay.bLoop = false;
+    if (!replay.load(path)) return false;
+
+    fixture.name = path;
+    fixture.width = replay.getWidth();
+    fixture.height = replay.getHeight();
+    fixture.zeroPlanePixelSize = replay.getZeroPlanePixelSize();
+    fixture.zeroPlaneDistance = replay.getZeroPlaneDistance();
+
+    fixture.frames.resize(replay.getFrameCount());
+    for (int i=0; i<replay.getFrameCount(); i++){
+        replay.setFrame(i);
+        fixture.frames[i].setFromPixels(replay.getRawDepthPixels().getData(), fixture.width, fixture.height, OF_PIXELS_GRAY);
+    }
+    if (fixture.frames.empty()) return false;
+
+    // take the table as the median reading of the first frame
+    const unsigned short * first = fixture.frames[0].getData();
+    vector<unsigned short> depths;
+    for (size_t i=0; i<(size_t)fixture.width * fixture.height; i++)
+        if (first[i] > 0) depths.push_back(first[i]);
+    if (!depths.empty()){
+        nth_element(depths.begin(), depths.begin() + depths.size() / 2, depths.end());
+        fixture.tableZ = depths[depths.size() / 2];
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------
+void makeSyntheticFixture(Fixture & fixture, int numHands){
+
+    fixture.name = numHands == 1 ? "synthetic" : "synthetic_" + ofToString(numHands) + "_hands";
+    fixture.frames.resize(60);
+
+    // hands side by side, in two rows once there are more than four
+    int rows = numHands > 4 ? 2 : 1;
+    int perRow = (numHands + rows - 1) / rows;
+
+    for (int f=0; f<(int)fixture.frames.size(); f++){
+
+        ofShortPixels & pix = fixture.frames[f];
+        pix.allocate(fixture.width, fixture.height, OF_PIXELS_GRAY);
+
+        // palms and four fingers sliding across, 25mm above the table, with a little noise
+        vector<ofVec2f> palms;
+        for (int i=0; i<numHands; i++){
+            float palmX = (i % perRow + 0.5f) * fixture.width / perRow + (f * 4 - 120) / perRow;
+            float palmY = rows == 1 ? 300 : 190 + (i / perRow) * 200;
+            palms.push_back(ofVec2f(palmX, palmY));
+        }
+
+        for (int y=0; y<fixture.height; y++){
+            for (int x=0; x<fixture.width; x++){
+                bool hand = false;
+                for (auto & palm : palms){
+                    hand = ofDistSquared(x, y, palm.x, palm.y) < 45 * 45;
+                    for (int k=0; k<4 && !hand; k++){
+                        float fx = palm.x - 36 + k * 24;
+                        hand = x >= fx - 7 && x <= fx + 7 && y <= palm.y - 20 && y >= palm.y - 95 + abs(k - 1.5f) * 12;
+                    }
+                    if (hand) break;
+                }
+                int noise = ((x * 7 + y * 13 + f * 5) % 5) - 2;
+                pix[y * fixture.width + x] = fixture.tableZ - (hand ? 25 : 0) + noise;
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void scaleFixture(Fixture & fixture, int scale){
+
+    int w = fixture.width * scale;
+    int h = fixture.height * scale;
+    ofShortPixels scaled;
+
+    for (auto & frame : fixture.frames){
+        scaled.allocate(w, h, OF_PIXELS_GRAY);
+        for (int y=0; y<h; y++)
+            for (int x=0; x<w; x++)
+                scaled[y * w + x] = frame[(y / scale) * fixture.width + x / scale];
+        frame = scaled;
+    }
+
+    fixture.name += "_x" + ofToString(scale);
+    fixture.width = w;
+    fixture.height = h;
+    fixture.zeroPlanePixelSize /= scale;
+}
+
+//--------------------------------------------------------------
+// the table inset by margin pixels as the workspace, and a zone 100mm tall above it
+void makeTableZone(const Fixture & fixture, const RayLUT & rays, int margin, InteractionZone & zone, ofPolyline & workspace){
+
+    int w = fixture.width;
+    int h = fixture.height;
+    int cornerX[4] = {margin, w - margin, w - margin, margin};
+    int cornerY[4] = {margin, margin, h - margin, h - margin};
+
+    vector<ofVec3f> corners;
+    for (int i=0; i<4; i++) corners.push_back(rays.getWorldCoordinateAt(cornerX[i], cornerY[i], fixture.tableZ));
+    for (int i=0; i<4; i++) corners.push_back(rays.getWorldCoordinateAt(cornerX[i], cornerY[i], fixture.tableZ - 100));
+    zone.setup(corners);
+    zone.touchHeight = 30;
+
+    workspace.clear();
+    for (int i=0; i<4; i++) workspace.addVertex(cornerX[i], cornerY[i]);
+    workspace.close();
+}
+
+//--------------------------------------------------------------
+template <class F>
+Result run(string stage, int iterations, F fn){
+
+    // warm up caches and let scratch buffers reach their working size
+    for (int i=0; i<MIN(iterations, 10); i++)
+        fn(i);
+
+    uint64_t allocStart = allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (int i=0; i<iterations; i++)
+        fn(i);
+    auto end = std::chrono::steady_clock::now();
+    uint64_t allocEnd = allocations;
+
+    Result r;
+    r.stage = stage;
+    r.iterations = iterations;
+    r.nsPerFrame = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+    r.allocsPerFrame = (double)(allocEnd - allocStart) / iterations;
+    return r;
+}
+
+//--------------------------------------------------------------
+bool checkTuio(){
+
+    const int port = 33333;
+    TuioReceiver receiver;
+    TuioSender sender;
+    if (!receiver.setup(port) || !sender.setup("127.0.0.1", port)) return false;
+
+    // two confirmed touches, one projected, and one still waiting to be confirmed
+    ofVec2f depthSize(640, 480);
+    ofVec2f projectorSize(1024, 768);
+    vector<Touch> touches(3);
+    touches[0].id = 3;
+    touches[0].position.set(160, 120);
+    touches[0].velocity.set(64, -48);
+    touches[0].bConfirmed = true;
+    touches[1].id = 7;
+    touches[1].position.set(320, 240);
+    touches[1].projected.set(256, 576);
+    touches[1].projectedVelocity.set(512, 0);
+    touches[1].bProjected = true;
+    touches[1].bConfirmed = true;
+    touches[2].position.set(600, 400);
+
+    if (!sender.send(touches, 42, depthSize, projectorSize)) return false;
+
+    bool received = false;
+    for (int i=0; i<100 && !received; i++){
+        received = receiver.update();
+        if (!received) ofSleepMillis(1);
+    }
+    if (!received) return false;
+
+    auto equal = [](float a, float b){ return fabs(a - b) < 1e-5f; };
+    const vector<TuioCursor> & c = receiver.cursors;
+    return receiver.frameSeq == 42 && receiver.alive == vector<int>({3, 7}) && c.size() == 2 &&
+        c[0].id == 3 && equal(c[0].x, 0.25f) && equal(c[0].y, 0.25f) && equal(c[0].vx, 0.1f) && equal(c[0].vy, -0.1f) &&
+        c[1].id == 7 && equal(c[1].x, 0.25f) && equal(c[1].y, 0.75f) && equal(c[1].vx, 0.5f) && equal(c[1].vy, 0);
+}
+
+//--------------------------------------------------------------
+bool checkGate(){
+
+    Fixture fixture;
+    makeSyntheticFixture(fixture, 1);
+    int w = fixture.width;
+    int h = fixture.height;
+    const int noiseMm = 8;
+    const int minChangedPixels = 100;
+    ofRectangle roi(20, 20, w - 40, h - 40);
+
+    // the first frame with a few sampled pixels on the hand's edge flipped to their
+    // neighbour's depth across the edge, as the Kinect does on a hand resting on the table
+    FrameGate gate;
+    const ofShortPixels & still = fixture.frames[0];
+    ofShortPixels flicker = still;
+    int flipped = 0;
+    for (int y=roi.y; y<roi.getBottom() && flipped < 4; y+=gate.step){
+        for (int x=roi.x; x+gate.step<roi.getRight() && flipped < 4; x+=gate.step){
+            int i = y * w + x;
+            if (abs(still[i] - still[i + gate.step]) > 15){
+                flicker[i] = still[i + gate.step];
+                flipped++;
+            }
+        }
+    }
+
+    // and with only the tip of the highest finger, from its top left pixel, pressed 15mm closer to the table
+    ofShortPixels press = still;
+    int tipX = -1, tipY = -1;
+    for (int y=0; y<h && tipY < 0; y++){
+        for (int x=0; x<w && tipY < 0; x++){
+            if (still[y * w + x] < fixture.tableZ - 15){
+                tipX = x;
+                tipY = y;
+            }
+        }
+    }
+    for (int y=tipY; y>=0 && y<MIN(tipY + 15, h); y++){
+        for (int x=tipX; x<MIN(tipX + 15, w); x++){
+            if (still[y * w + x] < fixture.tableZ - 15)
+                press[y * w + x] = still[y * w + x] + 15;
+        }
+    }
+
+    gate.isChanged(still, roi, noiseMm, minChangedPixels);
+    gate.setReference();
+    bool flickerChanged = gate.isChanged(flicker, roi, noiseMm, minChangedPixels);
+    if (flickerChanged)
+        ofLogError("bench") << "frame gate: " << flipped << " flickering edge samples count as a change";
+    bool pressChanged = gate.isChanged(press, roi, noiseMm, minChangedPixels);
+    if (!pressChanged)
+        ofLogError("bench") << "frame gate: missed a fingertip press, " << gate.changed << " samples changed";
+    bool movedChanged = gate.isChanged(fixture.frames[1], roi, noiseMm, minChangedPixels);
+    if (!movedChanged)
+        ofLogError("bench") << "frame gate: missed the hand moving";
+    return flipped > 0 && tipY >= 0 && !flickerChanged && pressChanged && movedChanged;
+}
+
+//--------------------------------------------------------------
+bool checkSmallBlob(){
+
+    // a fingertip seen end on: a 9x9 patch 20mm above an otherwise empty table, a contour
+    // shorter than 2k + 1 points for k-curvature, with the shipped blob sizes
+    Fixture fixture;
+    fixture.name = "small_blob";
+    fixture.frames.resize(1);
+    ofShortPixels & pix = fixture.frames[0];
+    pix.allocate(fixture.width, fixture.height, OF_PIXELS_GRAY);
+    for (int y=0; y<fixture.height; y++)
+        for (int x=0; x<fixture.width; x++)
+            pix[y * fixture.width + x] = fixture.tableZ - (abs(x - 320) <= 4 && abs(y - 240) <= 4 ? 20 : 0);
+
+    RayLUT rays;
+    rays.setupKinect(fixture.width, fixture.height, fixture.zeroPlanePixelSize, fixture.zeroPlaneDistance);
+
+    FixtureDepthSource source(fixture);
+    TouchPipeline pipeline;
+    pipeline.setup(&source);
+    TouchSettings settings;
+    settings.bUsePlaneHeight = true;
+    settings.minHeightMm = 10;
+    settings.maxHeightMm = 60;
+    settings.minArea = 53;
+    settings.maxArea = 400;
+    makeTableZone(fixture, rays, 20, settings.zone, settings.workspacePlane2D);
+    pipeline.setSettings(settings);
+
+    for (int i=0; i<settings.touchBirthFrames + 1; i++)
+        pipeline.processNext();
+    pipeline.update();
+
+    const TouchFrame & frame = pipeline.getFrame();
+    if (frame.blobs.size() != 1 || frame.touches.size() != 1){
+        ofLogError("bench") << "small blob: " << frame.blobs.size() << " blobs, " << frame.touches.size() << " touches, expected one of each";
+        return false;
+    }
+    if (frame.touches[0].position.distance(ofPoint(320, 240)) > 2){
+        ofLogError("bench") << "small blob: touch at " << frame.touches[0].position << ", expected 320, 240";
+        return false;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+int main(int argc, char *argv[]){
+
+    ofSetLogLevel(OF_LOG_WARNING);
+
+    string fixturePath;
+    string outPath = "kinect2touch_bench.json";
+    int iterations = 2000;
+    bool bCheckAllocs = false;
+    bool bCheckTuio = false;
+    bool bCheckGate = false;
+    bool bCheckSmallBlob = false;
+    int numHands = 1;
+    int numThreads = 0;
+    int scale = 1;
+    for (int i=1; i<argc; i++){
+        string arg = argv[i];
+        if (arg == "--iterations" && i+1 < argc){
+            iterations = ofToInt(argv[++i]);
+            iterations = MAX(1, iterations);
+        }
+        else if (arg == "--out" && i+1 < argc)
+            outPath = argv[++i];
+        else if (arg == "--check-allocs")
+            bCheckAllocs = true;
+        else if (arg == "--check-tuio")
+            bCheckTuio = true;
+        else if (arg == "--check-gate")
+            bCheckGate = true;
+        else if (arg == "--check-small-blob")
+            bCheckSmallBlob = true;
+        else if (arg == "--hands" && i+1 < argc){
+            numHands = ofToInt(argv[++i]);
+            numHands = MAX(1, numHands);
+        }
+        else if (arg == "--threads" && i+1 < argc)
+            numThreads = ofToInt(argv[++i]);
+        else if (arg == "--scale" && i+1 < argc){
+            scale = ofToInt(argv[++i]);
+            scale = MAX(1, scale);
+        }
+        else
+            fixturePath = arg;
+    }
+
+    if (bCheckTuio){
+        if (!checkTuio()){
+            ofLogError("bench") << "TUIO round trip through 127.0.0.1 failed";
+            return 1;
+        }
+        cout << "TUIO round trip ok" << endl;
+    }
+    if (bCheckGate){
+        if (!checkGate()) return 1;
+        cout << "frame gate ok" << endl;
+    }
+    if (bCheckSmallBlob){
+        if (!checkSmallBlob()) return 1;
+        cout << "small blob ok" << endl;
+    }
+
+    Fixture fixture;
+    if (fixturePath.empty())
+        makeSyntheticFixture(fixture, numHands);
+    else if (!loadFixture(fixturePath, fixture)){
+        ofLogError("bench") << "couldn't load " << fixturePath;
+        return 1;
+    }
+    if (scale > 1)
+        scaleFixture(fixture, scale);
+
+    // sizes in pixels grow with the scale
+    int minArea = 1500 * scale * scale;
+    int maxArea = 40000 * scale * scale;
+    int margin = 20 * scale;
+
+    int w = fixture.width;
+    int h = fixture.height;
+    size_t numPixels = (size_t)w * h;
+    size_t numFrames = fixture.frames.size();
+    ofRectangle full(0, 0, w, h);
+
+    RayLUT rays;
+    rays.setupKinect(w, h, fixture.zeroPlanePixelSize, fixture.zeroPlaneDistance);
+
+    // the table as the workspace surface, normal pointing up towards the camera
+    ofVec3f normal(0, 0, -1);
+    float d = fixture.tableZ;
+    HeightMap heightMap;
+    heightMap.setup(rays, normal, d);
+
+    InteractionZone zone;
+    ofPolyline workspace;
+    makeTableZone(fixture, rays, margin, zone, workspace);
+
+    // every stage's input, prepared once so each stage is timed on its own
+    vector<vector<short>> heights(numFrames);
+    vector<vector<unsigned char>> thresholded(numFrames, vector<unsigned char>(numPixels));
+    vector<vector<Blob>> blobs(numFrames);
+    vector<vector<Fingertip>> tips(numFrames);
+
+    BlobFinder blobFinder;
+    FingertipDetector fingertips;
+    fingertips.k *= scale;
+    size_t numBlobs = 0, numTips = 0;
+    for (size_t f=0; f<numFrames; f++){
+        heightMap.update(fixture.frames[f], full, heights[f]);
+        DepthThreshold::heightRange(heights[f].data(), thresholded[f].data(), numPixels, 10, 60);
+        blobFinder.findBlobs(thresholded[f].data(), w, h, minArea, maxArea, 64);
+        blobs[f] = blobFinder.blobs;
+        for (size_t b=0; b<blobs[f].size(); b++)
+            fingertips.find(blobs[f][b], b, tips[f]);
+        numBlobs += blobs[f].size();
+        numTips += tips[f].size();
+    }
+
+    vector<unsigned char> dst(numPixels);
+    vector<short> heightDst(numPixels);
+    vector<float> worldX(numPixels), worldY(numPixels), worldZ(numPixels);
+    vector<Fingertip> tipDst;
+    tipDst.reserve(256);
+    vector<float> tipX(256), tipY(256), tipZ(256);
+    vector<short> tipHeights(256);
+    vector<unsigned char> tipZones(256);
+    vector<ofPoint> touchPoints;
+    vector<int> touchBlobs;
+    touchPoints.reserve(256);
+    touchBlobs.reserve(256);
+    TouchTracker tracker;
+    tracker.setup(w, h);
+    tracker.matchDistance *= scale;
+
+    int nearMm = fixture.tableZ - 60;
+    int farMm = fixture.tableZ - 10;
+
+    vector<Result> results;
+
+    results.push_back(run("threshold", iterations, [&](int i){
+        DepthThreshold::bandRaw(fixture.frames[i % numFrames].getData(), dst.data(), numPixels, nearMm, farMm);
+    }));
+
+    results.push_back(run("threshold_scalar", iterations, [&](int i){
+        DepthThreshold::bandRawScalar(fixture.frames[i % numFrames].getData(), dst.data(), numPixels, nearMm, farMm);
+    }));
+
+    // the 8-bit band against the scalar loop and the two thresholds and cvAnd it replaced
+    vector<vector<unsigned char>> depth8(numFrames, vector<unsigned char>(numPixels));
+    for (size_t f=0; f<numFrames; f++)
+        for (size_t p=0; p<numPixels; p++)
+            depth8[f][p] = toDepth8(fixture.frames[f][p]);
+    int nearThreshold = toDepth8(nearMm);
+    int farThreshold = toDepth8(farMm);
+
+    results.push_back(run("band", iterations, [&](int i){
+        DepthThreshold::band(depth8[i % numFrames].data(), dst.data(), numPixels, nearThreshold, farThreshold);
+    }));
+
+    results.push_back(run("band_scalar", iterations, [&](int i){
+        DepthThreshold::bandScalar(depth8[i % numFrames].data(), dst.data(), numPixels, nearThreshold, farThreshold);
+    }));
+
+    ofxCvGrayscaleImage grayImage, grayThreshNear, grayThreshFar;
+    grayImage.allocate(w, h);
+    grayThreshNear.allocate(w, h);
+    grayThreshFar.allocate(w, h);
+    results.push_back(run("cv_and", iterations, [&](int i){
+        grayImage.setFromPixels(depth8[i % numFrames].data(), w, h);
+        grayThreshNear = grayImage;
+        grayThreshFar = grayImage;
+        grayThreshNear.threshold(nearThreshold, true);
+        grayThreshFar.threshold(farThreshold);
+        cvAnd(grayThreshNear.getCvImage(), grayThreshFar.getCvImage(), grayImage.getCvImage(), NULL);
+        grayImage.flagImageChanged();
+    }));
+
+    results.push_back(run("height_map", iterations, [&](int i){
+        heightMap.update(fixture.frames[i % numFrames], full, heightDst);
+    }));
+
+    results.push_back(run("height_threshold", iterations, [&](int i){
+        DepthThreshold::heightRange(heights[i % numFrames].data(), dst.data(), numPixels, 10, 60);
+    }));
+
+    results.push_back(run("contour", iterations, [&](int i){
+        blobFinder.findBlobs(thresholded[i % numFrames].data(), w, h, minArea, maxArea, 64);
+    }));
+
+    // the contour finder it replaced, with the same call on the same thresholded frames
+    vector<ofxCvGrayscaleImage> thresholdedImages(numFrames);
+    for (size_t f=0; f<numFrames; f++){
+        thresholdedImages[f].allocate(w, h);
+        thresholdedImages[f].setFromPixels(thresholded[f].data(), w, h);
+    }
+    ofxCvContourFinder contourFinder;
+    results.push_back(run("contour_cv", iterations, [&](int i){
+        contourFinder.findContours(thresholdedImages[i % numFrames], minArea, maxArea, 20, false);
+    }));
+
+    results.push_back(run("fingertip", iterations, [&](int i){
+        const vector<Blob> & frameBlobs = blobs[i % numFrames];
+        tipDst.clear();
+        for (size_t b=0; b<frameBlobs.size(); b++)
+            fingertips.find(frameBlobs[b], b, tipDst);
+    }));
+
+    results.push_back(run("world", iterations, [&](int i){
+        rays.toWorld(fixture.frames[i % numFrames].getData(), 0, numPixels, worldX.data(), worldY.data(), worldZ.data());
+    }));
+
+    results.push_back(run("touch", iterations, [&](int i){
+        const ofShortPixels & depth = fixture.frames[i % numFrames];
+        const vector<short> & frameHeights = heights[i % numFrames];
+        const vector<Fingertip> & frameTips = tips[i % numFrames];
+        size_t n = MIN(frameTips.size(), tipX.size());
+        for (size_t t=0; t<n; t++){
+            int x = frameTips[t].position.x;
+            int y = frameTips[t].position.y;
+            ofVec3f world = rays.getWorldCoordinateAt(x, y, depth[y * w + x]);
+            tipX[t] = world.x;
+            tipY[t] = world.y;
+            tipZ[t] = world.z;
+            tipHeights[t] = frameHeights[y * w + x];
+        }
+        zone.classify(tipX.data(), tipY.data(), tipZ.data(), tipHeights.data(), n, tipZones.data());
+        touchPoints.clear();
+        touchBlobs.clear();
+        for (size_t t=0; t<n; t++){
+            if (tipZones[t] != InteractionZone::TOUCH) continue;
+            touchPoints.push_back(frameTips[t].position);
+            touchBlobs.push_back(frameTips[t].blobIndex);
+        }
+        tracker.update(touchPoints, touchBlobs, (uint64_t)i * 33333);
+    }));
+
+    // what deciding to skip a static frame costs, against the previous frame
+    FrameGate gate;
+    results.push_back(run("frame_gate", iterations, [&](int i){
+        gate.isChanged(fixture.frames[i % numFrames], full, 8, 100);
+        gate.setReference();
+    }));
+
+    // the whole processing thread's work for a frame, on the same zone and thresholds
+    // the caller counts as one of the threads
+    WorkerPool workers;
+    if (numThreads != 1)
+        workers.setup(MAX(0, numThreads - 1));
+    FixtureDepthSource source(fixture);
+    TouchPipeline pipeline;
+    pipeline.setup(&source, &workers);
+    TouchSettings settings;
+    settings.bUsePlaneHeight = true;
+    settings.minHeightMm = 10;
+    settings.maxHeightMm = 60;
+    settings.minArea = minArea;
+    settings.maxArea = maxArea;
+    settings.fingertipK *= scale;
+    settings.touchMatchDistance *= scale;
+    settings.bTiled = workers.getNumThreads() > 1;
+    settings.zone = zone;
+    settings.workspacePlane2D = workspace;
+    pipeline.setSettings(settings);
+
+    // a few passes over the fixture first, so every buffer has seen its largest frame
+    for (size_t i=0; i<numFrames * 4; i++)
+        pipeline.processNext();
+    Result pipelineResult = run("pipeline", iterations, [&](int i){
+        pipeline.processNext();
+    });
+    results.push_back(pipelineResult);
+
+    // threshold and labelling in bands, on more and more threads
+    int maxThreads = MAX(1, (int)std::thread::hardware_concurrency());
+    vector<int> threadCounts;
+    for (int t=1; t<maxThreads; t*=2)
+        threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    struct {
+        const short * heights;
+        unsigned char * dst;
+        int width;
+    } band = {NULL, dst.data(), w};
+    auto thresholdBand = [&band](size_t begin, size_t end){
+        DepthThreshold::heightRange(band.heights + begin * band.width, band.dst + begin * band.width, (end - begin) * band.width, 10, 60);
+    };
+
+    BlobFinder tiledFinder;
+    vector<double> tiledNs;
+    for (int t : threadCounts){
+        WorkerPool pool;
+        if (t > 1)
+            pool.setup(t - 1);
+        tiledFinder.workers = &pool;
+        Result r = run("tiled_" + ofToString(t) + "t", iterations, [&](int i){
+            band.heights = heights[i % numFrames].data();
+            pool.parallelFor(h, thresholdBand, 16);
+            tiledFinder.findBlobs(dst.data(), w, h, minArea, maxArea, 64);
+        });
+        results.push_back(r);
+        tiledNs.push_back(r.nsPerFrame);
+    }
+
+    // a projector 1m above the table looking down, and 40 points it would have been clicked at
+    vector<ofVec2f> imagePoints;
+    vector<ofVec3f> worldPoints;
+    for (int i=0; i<40; i++){
+        ofVec3f world = rays.getWorldCoordinateAt(40 + (i % 8) * 75, 40 + (i / 8) * 90, fixture.tableZ - (i % 3) * 40);
+        ofVec3f p = world - ofVec3f(0, 0, fixture.tableZ - 1000);
+        imagePoints.push_back(ofVec2f(512 + 1400 * p.x / p.z, 384 + 1400 * p.y / p.z));
+        worldPoints.push_back(world);
+    }
+    CalibrateCoords calibration;
+    calibration.setup(1024, 768);
+    results.push_back(run("calibration_solve", MAX(1, iterations / 100), [&](int i){
+        calibration.loadPoints(imagePoints, worldPoints);
+        calibration.correctCamera();
+    }));
+
+    // machine readable, one stage per line
+    ofstream out(outPath.c_str());
+    out << "{\"fixture\":\"" << fixture.name << "\",\"width\":" << w << ",\"height\":" << h << ",\"frames\":" << numFrames
+        << ",\"blobsPerFrame\":" << ofToString((float)numBlobs / numFrames, 2) << ",\"fingertipsPerFrame\":" << ofToString((float)numTips / numFrames, 2)
+        << ",\"instructionSet\":\"" << DepthThreshold::getInstructionSet() << "\",\"threads\":" << workers.getNumThreads() << ",\"stages\":[" << endl;
+    for (size_t i=0; i<results.size(); i++){
+        const Result & r = results[i];
+        out << "{\"stage\":\"" << r.stage << "\",\"iterations\":" << r.iterations << ",\"nsPerFrame\":" << ofToString(r.nsPerFrame, 1)
+            << ",\"allocsPerFrame\":" << ofToString(r.allocsPerFrame, 2) << "}" << (i + 1 < results.size() ? "," : "") << endl;
+    }
+    out << "]}" << endl;
+
+    cout << fixture.name << " " << w << "x" << h << ", " << numFrames << " frames, " << (float)numBlobs / numFrames << " blobs and "
+        << (float)numTips / numFrames << " fingertips per frame, " << DepthThreshold::getInstructionSet() << ", " << workers.getNumThreads() << " threads" << endl;
+    for (auto & r : results)
+        cout << ofToString(r.stage, 20, ' ') << ofToString(r.nsPerFrame, 1, 14, ' ') << " ns/frame" << ofToString(r.allocsPerFrame, 2, 10, ' ') << " allocs/frame" << endl;
+    cout << "tiled speedup:";
+    for (size_t i=0; i<threadCounts.size(); i++)
+        cout << " " << threadCounts[i] << "t " << ofToString(tiledNs[0] / tiledNs[i], 2) << "x";
+    cout << endl;
+    cout << "results written to " << outPath << endl;
+
+    if (bCheckAllocs && pipelineResult.allocsPerFrame > 0){
+        ofLogError("bench") << "pipeline allocates " << pipelineResult.allocsPerFrame << " times per frame";
+        return 1;
+    }
+
+    return 0;
+}
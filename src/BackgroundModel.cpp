@@ -0,0 +1,71 @@
+#include "BackgroundModel.h"
+
+
+void BackgroundModel::learn(int width, int height, int numFrames){
+
+    background.allocate(width, height, OF_PIXELS_GRAY);
+    background.set(0);
+
+    sum.assign(width * height, 0);
+    count.assign(width * height, 0);
+
+    framesWanted = MAX(numFrames, 1);
+    framesAdded = 0;
+
+    ofLogNotice("BackgroundModel") << "learning background over " << framesWanted << " frames";
+}
+
+void BackgroundModel::addFrame(const ofShortPixels & rawDepth){
+
+    if (!isLearning()) return;
+
+    const unsigned short * depth = rawDepth.getData();
+    size_t numPixels = sum.size();
+
+    // pixels without a reading don't count towards the average
+    for (size_t i=0; i<numPixels; i++){
+        if (depth[i] != 0){
+            sum[i] += depth[i];
+            count[i]++;
+        }
+    }
+
+    framesAdded++;
+
+    if (framesAdded == framesWanted){
+
+        unsigned short * bg = background.getData();
+        for (size_t i=0; i<numPixels; i++)
+            bg[i] = count[i] > 0 ? sum[i] / count[i] : 0;
+
+        sum.clear();
+        count.clear();
+
+        ofLogNotice("BackgroundModel") << "background learned";
+    }
+}
+
+bool BackgroundModel::isLearning(){
+    return framesAdded < framesWanted;
+}
+
+bool BackgroundModel::isReady(){
+    return framesWanted > 0 && framesAdded == framesWanted;
+}
+
+// stored as a 16-bit grayscale png, one mm per level
+bool BackgroundModel::save(string filePath){
+
+    if (!isReady()) return false;
+
+    ofSaveImage(background, filePath);
+    return true;
+}
+
+bool BackgroundModel::load(string filePath){
+
+    if (!ofLoadImage(background, filePath)) return false;
+
+    framesWanted = framesAdded = 1;
+    return true;
+}
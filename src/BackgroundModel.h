@@ -0,0 +1,29 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Per-pixel depth of the empty table, averaged over a number of frames.
+// Touch segmentation then measures height above this surface instead of using one global
+// near/far band, so a tilted sensor doesn't clip the far corner or let the whole table in.
+class BackgroundModel {
+public:
+
+    // start averaging the next numFrames frames
+    void learn(int width, int height, int numFrames);
+    void addFrame(const ofShortPixels & rawDepth);
+
+    bool isLearning();
+    bool isReady();
+
+    bool save(string filePath);
+    bool load(string filePath);
+
+    ofShortPixels background;   // averaged depth in mm, 0 where the sensor never got a reading
+
+    int framesWanted = 0;
+    int framesAdded = 0;
+
+    vector<unsigned int> sum;
+    vector<unsigned short> count;
+
+};
@@ -0,0 +1,270 @@
+#include "BlobFinder.h"
+
+// clockwise neighbours, starting east (y points down)
+static const int dx[8] = { 1, 1, 0,-1,-1,-1, 0, 1 };
+static const int dy[8] = { 0, 1, 1, 1, 0,-1,-1,-1 };
+
+// sum of k^2 for k = 0..n
+static inline double sumSquares(double n){
+    return n * (n + 1) * (2 * n + 1) / 6;
+}
+
+void Blob::draw(float x, float y) const{
+
+    ofPushStyle();
+    ofNoFill();
+    ofSetHexColor(0x00FFFF);
+    ofBeginShape();
+    for (auto &pt : pts)
+        ofVertex(x + pt.x, y + pt.y);
+    ofEndShape(true);
+    ofSetHexColor(0xff0099);
+    ofDrawRectangle(x + boundingRect.x, y + boundingRect.y, boundingRect.width, boundingRect.height);
+    ofPopStyle();
+}
+
+int BlobFinder::findBlobs(const unsigned char * pixels, int width, int height, int minArea, int maxArea, int maxBlobs, int offsetX, int offsetY){
+
+    // one band, or one per thread in tiled mode, each at least a few rows high
+    int nBands = 1;
+    if (workers && workers->getNumThreads() > 1)
+        nBands = numBands > 0 ? numBands : workers->getNumThreads();
+    nBands = MAX(1, MIN(nBands, height / MIN_BAND_ROWS));
+
+    if (bands.size() < nBands)
+        bands.resize(nBands);
+    for (int i=0; i<nBands; i++){
+        bands[i].y0 = height * i / nBands;
+        bands[i].y1 = height * (i + 1) / nBands;
+    }
+
+    rowStart.resize(height + 1);
+    bandPixels = pixels;
+    bandWidth = width;
+    if (nBands > 1){
+        workers->parallelFor(nBands, [this](size_t begin, size_t end){
+            for (size_t i=begin; i<end; i++)
+                labelBand(bands[i]);
+        });
+    }
+    else{
+        labelBand(bands[0]);
+    }
+
+    // join the bands, offsetting each one's run indices by the runs before it
+    if (nBands == 1){
+        runs.swap(bands[0].runs);
+        parent.swap(bands[0].parent);
+    }
+    else{
+        runs.clear();
+        parent.clear();
+        for (int i=0; i<nBands; i++){
+            Band & band = bands[i];
+            int offset = runs.size();
+            for (int y=band.y0; y<band.y1; y++)
+                rowStart[y] += offset;
+            runs.insert(runs.end(), band.runs.begin(), band.runs.end());
+            for (int p : band.parent)
+                parent.push_back(p + offset);
+        }
+    }
+    rowStart[height] = runs.size();
+
+    // and merge the runs that touch across each seam
+    for (int i=1; i<nBands; i++){
+        int y = bands[i].y0;
+        mergeRows(runs, parent, rowStart[y - 1], rowStart[y], rowStart[y], rowStart[y + 1]);
+    }
+
+    // accumulate area, bounds and moments per component in full frame coordinates
+    components.clear();
+    componentOf.resize(runs.size());
+    for (int i=0; i<runs.size(); i++){
+
+        Run & run = runs[i];
+        run.label = findRoot(parent, i);
+
+        if (run.label == i){
+            componentOf[i] = components.size();
+            components.push_back({0, run.x0, run.y, run.x1, run.y, 0, 0, 0, 0, 0, i});
+        }
+
+        Component & c = components[componentOf[run.label]];
+
+        int n = run.x1 - run.x0 + 1;
+        double x0 = run.x0 + offsetX;
+        double x1 = run.x1 + offsetX;
+        double y = run.y + offsetY;
+        double sumX = (x0 + x1) * n * 0.5;
+
+        c.area += n;
+        c.minX = MIN(c.minX, run.x0);
+        c.maxX = MAX(c.maxX, run.x1);
+        c.maxY = run.y;
+        c.m10 += sumX;
+        c.m01 += n * y;
+        c.m20 += sumSquares(x1) - sumSquares(x0 - 1);
+        c.m11 += y * sumX;
+        c.m02 += n * y * y;
+    }
+
+    // keep the ones in range, largest first
+    order.clear();
+    for (int i=0; i<components.size(); i++){
+        if (components[i].area >= minArea && components[i].area <= maxArea)
+            order.push_back(i);
+    }
+    // ties keep label order, like a stable sort but without its temporary buffer
+    std::sort(order.begin(), order.end(), [this](int a, int b){
+        return components[a].area != components[b].area ? components[a].area > components[b].area : a < b;
+    });
+
+    // blobs move to and from the spares instead of being destroyed, so their contours keep their capacity
+    nBlobs = MIN((int)order.size(), maxBlobs);
+    while ((int)blobs.size() > nBlobs){
+        spare.push_back(std::move(blobs.back()));
+        blobs.pop_back();
+    }
+    while ((int)blobs.size() < nBlobs){
+        if (spare.empty()){
+            blobs.emplace_back();
+            continue;
+        }
+        blobs.push_back(std::move(spare.back()));
+        spare.pop_back();
+    }
+
+    for (int i=0; i<nBlobs; i++){
+
+        const Component & c = components[order[i]];
+        Blob & blob = blobs[i];
+
+        blob.area = c.area;
+        blob.boundingRect.set(c.minX + offsetX, c.minY + offsetY, c.maxX - c.minX + 1, c.maxY - c.minY + 1);
+        blob.m00 = c.area;
+        blob.m10 = c.m10;
+        blob.m01 = c.m01;
+        blob.m20 = c.m20;
+        blob.m11 = c.m11;
+        blob.m02 = c.m02;
+        blob.centroid.set(c.m10 / c.area, c.m01 / c.area);
+
+        const Run & first = runs[c.firstRun];
+        traceContour(pixels, width, height, first.x0, first.y, blob, offsetX, offsetY);
+    }
+
+    return nBlobs;
+}
+
+// Collects the band's runs of foreground pixels row by row, then merges each run with the runs
+// it touches in the row above (8-connected). The lower run index always wins, so every root is
+// its component's first run, which still holds once the bands are joined.
+void BlobFinder::labelBand(Band & band){
+
+    band.runs.clear();
+    for (int y=band.y0; y<band.y1; y++){
+
+        rowStart[y] = band.runs.size();
+        const unsigned char * row = bandPixels + (size_t)y * bandWidth;
+
+        int x = 0;
+        while (x < bandWidth){
+            while (x < bandWidth && !row[x]) x++;
+            if (x == bandWidth) break;
+            int x0 = x;
+            while (x < bandWidth && row[x]) x++;
+            band.runs.push_back({x0, x - 1, y, (int)band.runs.size()});
+        }
+    }
+
+    band.parent.resize(band.runs.size());
+    for (int i=0; i<band.runs.size(); i++)
+        band.parent[i] = i;
+
+    // rowStart past the band's last row belongs to the next band
+    for (int y=band.y0 + 1; y<band.y1; y++){
+        int end = y + 1 < band.y1 ? rowStart[y + 1] : band.runs.size();
+        mergeRows(band.runs, band.parent, rowStart[y - 1], rowStart[y], rowStart[y], end);
+    }
+}
+
+// merges the runs [start, end) of a row with the ones they touch in [prevStart, prevEnd), the row above
+void BlobFinder::mergeRows(vector<Run> & runs, vector<int> & parent, int prevStart, int prevEnd, int start, int end){
+
+    int j = prevStart;
+    for (int i=start; i<end; i++){
+
+        const Run & run = runs[i];
+        while (j < prevEnd && runs[j].x1 < run.x0 - 1) j++;
+
+        for (int k=j; k<prevEnd && runs[k].x0 <= run.x1 + 1; k++){
+            int a = findRoot(parent, i);
+            int b = findRoot(parent, k);
+            if (a < b) parent[b] = a;
+            else if (b < a) parent[a] = b;
+        }
+    }
+}
+
+int BlobFinder::findRoot(vector<int> & parent, int label){
+
+    int root = label;
+    while (parent[root] != root)
+        root = parent[root];
+
+    // path compression
+    while (parent[label] != root){
+        int next = parent[label];
+        parent[label] = root;
+        label = next;
+    }
+    return root;
+}
+
+// Moore neighbour tracing of the outer boundary, starting from the blob's topmost-leftmost
+// pixel (so everything west and north of it is background). Stops on Jacob's criterion:
+// back at the start pixel and about to leave it the same way as the first time.
+void BlobFinder::traceContour(const unsigned char * pixels, int width, int height, int startX, int startY, Blob & blob, int offsetX, int offsetY){
+
+    blob.pts.clear();
+    blob.pts.push_back(ofPoint(startX + offsetX, startY + offsetY));
+
+    int x = startX;
+    int y = startY;
+    int back = 4;       // direction of the last background pixel checked
+    int firstDir = -1;
+
+    while (true){
+
+        int dir = -1;
+        for (int i=1; i<8; i++){
+            int d = (back + i) & 7;
+            int nx = x + dx[d];
+            int ny = y + dy[d];
+            if (nx >= 0 && ny >= 0 && nx < width && ny < height && pixels[(size_t)ny * width + nx]){
+                dir = d;
+                break;
+            }
+        }
+
+        // single pixel blob
+        if (dir < 0) break;
+
+        if (firstDir < 0) firstDir = dir;
+        else if (x == startX && y == startY && dir == firstDir) break;
+
+        x += dx[dir];
+        y += dy[dir];
+        blob.pts.push_back(ofPoint(x + offsetX, y + offsetY));
+
+        // the background pixel checked just before dir, seen from the new pixel
+        back = (dir & 1) ? (dir + 5) & 7 : (dir + 6) & 7;
+    }
+
+    // the walk ends by stepping back onto the start pixel
+    if (blob.pts.size() > 1)
+        blob.pts.pop_back();
+
+    blob.nPts = blob.pts.size();
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "ofMain.h"
+#include "WorkerPool.h"
+
+struct Blob {
+    int area = 0;               // pixel count
+    ofRectangle boundingRect;
+    ofPoint centroid;
+
+    // raw image moments, sum of x^i * y^j over the blob's pixels
+    double m00 = 0, m10 = 0, m01 = 0;
+    double m20 = 0, m11 = 0, m02 = 0;
+
+    vector<ofPoint> pts;        // outer contour, every boundary pixel in clockwise order
+    int nPts = 0;
+
+    void draw(float x = 0, float y = 0) const;
+};
+
+// Single-pass connected components on a binary image, replacing ofxCvContourFinder.
+// Foreground pixels are collected as horizontal runs, runs that touch (8-connected) are merged
+// with union-find, and area, bounding box, centroid and moments fall out of the same pass.
+// Contours are only traced for the blobs that survive the area filter, and every buffer is
+// kept between frames, so once they've grown to the scene nothing is allocated.
+class BlobFinder {
+public:
+
+    // pixels is width x height, non-zero = foreground. Results are offset by (offsetX, offsetY),
+    // so a region of interest can be passed in and blobs still come back in full frame coordinates.
+    // Blobs are sorted largest first. Returns the number of blobs found.
+    // blobs can be swapped out for another vector of blobs between calls, their buffers are reused.
+    int findBlobs(const unsigned char * pixels, int width, int height, int minArea, int maxArea, int maxBlobs, int offsetX = 0, int offsetY = 0);
+
+    vector<Blob> blobs;
+    int nBlobs = 0;
+
+    // tiled mode: with a worker pool the image is cut into numBands horizontal bands (0 = one per
+    // thread) whose runs are collected and merged in parallel, then the runs that touch across
+    // each seam are merged. Finds exactly the same blobs as a single band.
+    WorkerPool * workers = NULL;
+    int numBands = 0;
+
+private:
+
+    struct Run {
+        int x0, x1;     // inclusive
+        int y;
+        int label;
+    };
+
+    struct Band {
+        int y0, y1;             // rows [y0, y1)
+        vector<Run> runs;       // indices local to the band until the bands are joined
+        vector<int> parent;
+    };
+
+    struct Component {
+        int area;
+        int minX, minY, maxX, maxY;
+        double m10, m01, m20, m11, m02;
+        int firstRun;   // topmost-leftmost run, where contour tracing starts
+    };
+
+    void labelBand(Band & band);
+    void mergeRows(vector<Run> & runs, vector<int> & parent, int prevStart, int prevEnd, int start, int end);
+    int findRoot(vector<int> & parent, int label);
+    void traceContour(const unsigned char * pixels, int width, int height, int startX, int startY, Blob & blob, int offsetX, int offsetY);
+
+    vector<Run> runs;
+    vector<int> rowStart;       // index of the first run in each row, plus one past the end
+    vector<int> parent;
+    vector<int> componentOf;    // root label -> index into components
+    vector<Component> components;
+    vector<int> order;
+    vector<Band> bands;
+    const unsigned char * bandPixels = NULL;    // image being scanned, for labelBand
+    int bandWidth = 0;
+    static const int MIN_BAND_ROWS = 16;
+    vector<Blob> spare;         // blobs no longer in use, with their contour buffers
+
+};
@@ -1,5 +1,6 @@
 #include "CalibrateCoords.h"
 #include "ofxXmlSettings.h"
+#include "Trace.h"
 
 
 void CalibrateCoords::setup(int camWidth, int camHeight){
@@ -7,6 +8,7 @@ void CalibrateCoords::setup(int camWidth, int camHeight){
     //  cameraHeight	= 768;
     resolution.set(camWidth,camHeight);
     calibrated				= false;
+    reprojectionError		= 0;
     hasFingerCalibPoints	= false;
     switchYandZ				= false;
     
@@ -100,6 +102,8 @@ void CalibrateCoords::loadPoints(vector<ofVec2f> image, vector<ofVec3f> world){
 
 void CalibrateCoords::correctCameraPNP (ofxCv::Calibration & myCalibration){
     
+    TRACE_SCOPE("CalibrateCoords::correctCameraPNP");
+    
     vector<cv::Point2f> imagePoints;
     vector<cv::Point3f> worldPoints;
     
@@ -157,6 +161,8 @@ void CalibrateCoords::correctCameraPNP (ofxCv::Calibration & myCalibration){
 
 void CalibrateCoords::correctCamera(){
     
+    TRACE_SCOPE("CalibrateCoords::correctCamera");
+    
     //we have to intitialise a basic camera matrix for it to start with (this will get changed by the function call calibrateCamera
     
     vector<cv::Point2f> imagePoints;
@@ -200,6 +206,7 @@ void CalibrateCoords::correctCamera(){
     cout << " cameraMatrix " << cameraMatrix << endl;
     
     calibrated = true;
+    reprojectionError = error;
     
     setExtrinsics(rotations[0], translations[0]);
     setIntrinsics(cameraMatrix);
@@ -211,6 +218,53 @@ void CalibrateCoords::correctCamera(){
     
 }
 
+void CalibrateCoords::saveSolution(CalibrationFile & file){
+    
+    CalibrationFileHeader & header = file.header;
+    header.hasSolution = calibrated;
+    if (!calibrated) return;
+    
+    header.width = resolution.x;
+    header.height = resolution.y;
+    for (int i=0; i<9; i++) header.camera[i] = camera.at<double>(i / 3, i % 3);
+    for (int i=0; i<5; i++) header.distortion[i] = i < distortion.total() ? distortion.at<double>(i) : 0;
+    for (int i=0; i<3; i++) header.rotation[i] = rotation.at<double>(i);
+    for (int i=0; i<3; i++) header.translation[i] = translation.at<double>(i);
+    header.reprojectionError = reprojectionError;
+    header.pointsHash = file.getPointsHash(resolution.x, resolution.y);
+}
+
+bool CalibrateCoords::loadSolution(const CalibrationFile & file){
+    
+    // the stored model is only good for the points and resolution it was solved from
+    const CalibrationFileHeader & header = file.header;
+    if (!header.hasSolution || header.width != resolution.x || header.height != resolution.y ||
+        header.pointsHash != file.getPointsHash(resolution.x, resolution.y)){
+        ofLogNotice("CalibrateCoords") << "no stored camera for these points, solving";
+        return false;
+    }
+    
+    // clone so the mats own their data, not the header's
+    cv::Mat cameraMatrix = cv::Mat(3, 3, CV_64F, (void *)header.camera).clone();
+    cv::Mat distortionCoefficients = cv::Mat(5, 1, CV_64F, (void *)header.distortion).clone();
+    cv::Mat rvec = cv::Mat(3, 1, CV_64F, (void *)header.rotation).clone();
+    cv::Mat tvec = cv::Mat(3, 1, CV_64F, (void *)header.translation).clone();
+    
+    calibrated = true;
+    reprojectionError = header.reprojectionError;
+    
+    setExtrinsics(rvec, tvec);
+    setIntrinsics(cameraMatrix);
+    
+    this->camera = cameraMatrix;
+    this->distortion = distortionCoefficients;
+    this->rotation = rvec;
+    this->translation = tvec;
+    
+    ofLogNotice("CalibrateCoords") << "using the stored camera, reprojection error " << reprojectionError;
+    return true;
+}
+
 void CalibrateCoords::setIntrinsics(cv::Mat cameraMatrix)
 {
     float fovx = cameraMatrix.at<double>(0, 0);
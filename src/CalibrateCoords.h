@@ -4,6 +4,7 @@
 #include "ofxOpenCv.h"
 #include "ofxCv.h"
 #include "ofxRay.h"
+#include "CalibrationFile.h"
 //#include "ofxCvMin.h"
 
 // based on calibration routine for Augmented Hand Series: https://github.com/CreativeInquiry/digital_art_2014/blob/master/HandArtwork/src/LeapToCameraCalibrator.cpp
@@ -25,6 +26,10 @@ public:
     void setIntrinsics(cv::Mat cameraMatrix);
     void setExtrinsics(cv::Mat rotation, cv::Mat translation);
     
+    // store / restore the solved camera model, so it doesn't have to be solved again
+    void saveSolution(CalibrationFile & file);
+    bool loadSolution(const CalibrationFile & file);
+    
     void drawWorldPoints();
     void drawImagePoints();
     
@@ -49,6 +54,7 @@ public:
     vector<ofVec3f> calibVectorWorld;
     cv::Mat camera, distortion;
     cv::Mat rotation, translation;
+    float reprojectionError;
     ofProjector projector;
     string dirNameLoaded;
     
@@ -0,0 +1,129 @@
+#include "CalibrationFile.h"
+
+
+static void initHeader(CalibrationFileHeader & header){
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "K2TC", 4);
+    header.version = CALIBRATION_FILE_VERSION;
+}
+
+CalibrationFile::CalibrationFile(){
+    initHeader(header);
+}
+
+bool CalibrationFile::load(string filePath){
+
+    ofBuffer buffer = ofBufferFromFile(filePath, true);
+
+    CalibrationFileHeader loaded;
+    if (buffer.size() < sizeof(loaded)){
+        return false;
+    }
+    memcpy(&loaded, buffer.getData(), sizeof(loaded));
+
+    if (memcmp(loaded.magic, "K2TC", 4) != 0 || loaded.version != CALIBRATION_FILE_VERSION){
+        ofLogError("CalibrationFile") << filePath << " is not a version " << CALIBRATION_FILE_VERSION << " calibration file";
+        return false;
+    }
+
+    size_t headerSize = sizeof(loaded);
+    if (buffer.size() < headerSize + loaded.numPoints * sizeof(CalibrationPoint)){
+        ofLogError("CalibrationFile") << filePath << " is truncated";
+        return false;
+    }
+
+    header = loaded;
+    points.resize(header.numPoints);
+    if (header.numPoints > 0)
+        memcpy(points.data(), buffer.getData() + headerSize, header.numPoints * sizeof(CalibrationPoint));
+
+    ofLogNotice("CalibrationFile") << "loaded " << header.numPoints << " points from " << filePath
+        << (header.hasSolution ? ", with solved camera" : "");
+    return true;
+}
+
+bool CalibrationFile::save(string filePath){
+
+    string path = ofToDataPath(filePath);
+    FILE * file = fopen(path.c_str(), "wb");
+    if (file == NULL){
+        ofLogError("CalibrationFile") << "couldn't open " << path << " for writing";
+        return false;
+    }
+
+    memcpy(header.magic, "K2TC", 4);
+    header.version = CALIBRATION_FILE_VERSION;
+    header.numPoints = points.size();
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (ok && !points.empty())
+        ok = fwrite(points.data(), sizeof(CalibrationPoint), points.size(), file) == points.size();
+    fclose(file);
+
+    if (!ok) ofLogError("CalibrationFile") << "couldn't write " << path;
+    return ok;
+}
+
+bool CalibrationFile::loadText(string imagePath, string worldPath){
+
+    ofBuffer image = ofBufferFromFile(imagePath);
+    ofBuffer world = ofBufferFromFile(worldPath);
+    if (!image.size() || !world.size()) return false;
+
+    initHeader(header);
+    points.clear();
+
+    auto imageLine = image.getLines().begin();
+    auto worldLine = world.getLines().begin();
+    auto imageEnd = image.getLines().end();
+    auto worldEnd = world.getLines().end();
+
+    for (; imageLine != imageEnd && worldLine != worldEnd; ++imageLine, ++worldLine){
+        CalibrationPoint pt;
+        if (sscanf((*imageLine).c_str(), "%f, %f", &pt.imageX, &pt.imageY) != 2) continue;
+        if (sscanf((*worldLine).c_str(), "%f, %f, %f", &pt.worldX, &pt.worldY, &pt.worldZ) != 3) continue;
+        points.push_back(pt);
+    }
+    header.numPoints = points.size();
+
+    ofLogNotice("CalibrationFile") << "converted " << points.size() << " points from " << imagePath << " and " << worldPath;
+    return !points.empty();
+}
+
+void CalibrationFile::setPoints(const vector<ofVec2f> & imagePoints, const vector<ofVec3f> & worldPoints){
+
+    // new points invalidate any solution
+    initHeader(header);
+    points.resize(MIN(imagePoints.size(), worldPoints.size()));
+    for (size_t i=0; i<points.size(); i++)
+        points[i] = {imagePoints[i].x, imagePoints[i].y, worldPoints[i].x, worldPoints[i].y, worldPoints[i].z};
+    header.numPoints = points.size();
+}
+
+void CalibrationFile::getPoints(vector<ofVec2f> & imagePoints, vector<ofVec3f> & worldPoints) const{
+
+    imagePoints.clear();
+    worldPoints.clear();
+    for (auto &pt : points){
+        imagePoints.push_back(ofVec2f(pt.imageX, pt.imageY));
+        worldPoints.push_back(ofVec3f(pt.worldX, pt.worldY, pt.worldZ));
+    }
+}
+
+uint64_t CalibrationFile::getPointsHash(int width, int height) const{
+
+    uint64_t hash = 14695981039346656037ULL;
+    auto add = [&hash](const void * data, size_t size){
+        const unsigned char * bytes = (const unsigned char *)data;
+        for (size_t i=0; i<size; i++){
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+    };
+
+    uint32_t resolution[2] = {(uint32_t)width, (uint32_t)height};
+    add(resolution, sizeof(resolution));
+    if (!points.empty())
+        add(points.data(), points.size() * sizeof(CalibrationPoint));
+    return hash;
+}
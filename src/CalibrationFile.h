@@ -0,0 +1,57 @@
+#pragma once
+
+#include "ofMain.h"
+
+// On-disk layout of a projector calibration (*.k2tc):
+//
+//   CalibrationFileHeader
+//   numPoints x CalibrationPoint
+//
+// Replaces imagePts.txt / worldPts.txt. The solved camera model is stored next to the
+// points it was solved from, keyed by a hash of those points and the projector resolution,
+// so startup can load it instead of running calibrateCamera again until the points change.
+
+struct CalibrationFileHeader {
+    char magic[4];              // "K2TC"
+    uint32_t version;
+    uint32_t numPoints;
+    uint32_t hasSolution;       // the camera model below is valid
+    uint32_t width;             // projector resolution the model was solved for
+    uint32_t height;
+    double camera[9];           // 3x3 camera matrix, row major
+    double distortion[5];       // k1 k2 p1 p2 k3
+    double rotation[3];         // Rodrigues vector
+    double translation[3];
+    double reprojectionError;   // rms, in projector pixels
+    uint64_t pointsHash;        // getPointsHash() of the points the model was solved from
+};
+
+struct CalibrationPoint {
+    float imageX, imageY;           // projector pixel
+    float worldX, worldY, worldZ;   // fingertip in depth camera world coordinates (mm)
+};
+
+static const uint32_t CALIBRATION_FILE_VERSION = 2;
+
+class CalibrationFile {
+public:
+
+    CalibrationFile();
+
+    // the whole file in one read
+    bool load(string filePath);
+    bool save(string filePath);
+
+    // converts the old text files: one "x, y" per line and one "x, y, z" per line
+    bool loadText(string imagePath, string worldPath);
+
+    void setPoints(const vector<ofVec2f> & imagePoints, const vector<ofVec3f> & worldPoints);
+    void getPoints(vector<ofVec2f> & imagePoints, vector<ofVec3f> & worldPoints) const;
+
+    // FNV-1a over the point pairs and the resolution a model would be solved for
+    uint64_t getPointsHash(int width, int height) const;
+
+    CalibrationFileHeader header;
+    vector<CalibrationPoint> points;
+
+};
@@ -0,0 +1,86 @@
+#include "DepthRecorder.h"
+
+
+DepthRecorder::~DepthRecorder(){
+    close();
+}
+
+bool DepthRecorder::open(string filePath, DepthSource & source, bool withColor){
+
+    close();
+
+    // nothing to record if the video stream is disabled
+    withColor = withColor && source.getPixels().isAllocated();
+
+    path = ofToDataPath(filePath);
+    file = fopen(path.c_str(), "wb");
+    if (file == NULL){
+        ofLogError("DepthRecorder") << "could not open " << path << " for writing";
+        return false;
+    }
+
+    memcpy(header.magic, "K2TD", 4);
+    header.version = DEPTH_RECORDING_VERSION;
+    header.width = source.getWidth();
+    header.height = source.getHeight();
+    header.hasColor = withColor ? 1 : 0;
+    header.frameCount = 0;
+    header.zeroPlanePixelSize = source.getZeroPlanePixelSize();
+    header.zeroPlaneDistance = source.getZeroPlaneDistance();
+
+    if (!write(&header, sizeof(header))) return false;
+
+    size_t numPixels = (size_t)header.width * header.height;
+    size_t used = sizeof(uint64_t) + numPixels * sizeof(uint16_t) + (withColor ? numPixels * 3 : 0);
+    padding.assign(depthRecordingFrameSize(header) - used, 0);
+
+    ofLogNotice("DepthRecorder") << "recording to " << path;
+
+    return true;
+}
+
+void DepthRecorder::addFrame(DepthSource & source){
+
+    if (!isRecording()) return;
+
+    size_t numPixels = (size_t)header.width * header.height;
+
+    uint64_t timestamp = source.getFrameTimestamp();
+    if (!write(&timestamp, sizeof(timestamp))) return;
+    if (!write(source.getRawDepthPixels().getData(), numPixels * sizeof(uint16_t))) return;
+
+    if (header.hasColor && !write(source.getPixels().getData(), numPixels * 3)) return;
+
+    if (!padding.empty() && !write(padding.data(), padding.size())) return;
+
+    header.frameCount++;
+}
+
+bool DepthRecorder::write(const void * data, size_t size){
+
+    if (fwrite(data, 1, size, file) == size) return true;
+
+    // the frame count in the header leaves the partial frame out of the replay
+    ofLogError("DepthRecorder") << "write to " << path << " failed after " << header.frameCount << " frames, stopping the recording";
+    close();
+    return false;
+}
+
+void DepthRecorder::close(){
+
+    if (!isRecording()) return;
+
+    // patch the final frame count into the header
+    bool ok = fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = fclose(file) == 0 && ok;
+    file = NULL;
+
+    if (ok)
+        ofLogNotice("DepthRecorder") << "wrote " << header.frameCount << " frames to " << path;
+    else
+        ofLogError("DepthRecorder") << "couldn't finish " << path << ", it may not replay";
+}
+
+bool DepthRecorder::isRecording(){
+    return file != NULL;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "ofMain.h"
+#include "DepthSource.h"
+
+// On-disk layout of a recorded session (*.k2td):
+//
+//   DepthRecordingHeader
+//   frame 0: uint64 timestamp (us) | uint16 raw depth [w*h] | uint8 rgb [w*h*3] | pad to 8 bytes
+//   frame 1: ...
+//
+// Every frame record has the same size so the replay source can memory-map the
+// file and index frames directly.
+
+struct DepthRecordingHeader {
+    char magic[4];              // "K2TD"
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t hasColor;
+    uint32_t frameCount;
+    float zeroPlanePixelSize;
+    float zeroPlaneDistance;
+};
+
+static const uint32_t DEPTH_RECORDING_VERSION = 1;
+
+// size in bytes of one frame record, rounded up so every record stays 8-byte aligned
+inline size_t depthRecordingFrameSize(const DepthRecordingHeader & header){
+    size_t numPixels = (size_t)header.width * header.height;
+    size_t size = sizeof(uint64_t) + numPixels * sizeof(uint16_t);
+    if (header.hasColor) size += numPixels * 3;
+    return (size + 7) & ~(size_t)7;
+}
+
+// Appends frames from a DepthSource to a session file that ReplayDepthSource can play back.
+class DepthRecorder {
+public:
+
+    ~DepthRecorder();
+
+    bool open(string filePath, DepthSource & source, bool withColor = true);
+    void addFrame(DepthSource & source);
+    void close();
+
+    bool isRecording();
+
+    DepthRecordingHeader header = DepthRecordingHeader();
+    FILE * file = NULL;
+    string path;
+
+    vector<char> padding;
+
+private:
+
+    // false on a short write (disk full, I/O error), which also stops the recording
+    bool write(const void * data, size_t size);
+
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Anything that can hand the touch pipeline depth + RGB frames.
+// The live Kinect and recorded sessions both implement this, so the pipeline
+// can be profiled and regressed on machines without a sensor attached.
+class DepthSource {
+public:
+
+    virtual ~DepthSource() {}
+
+    virtual bool open() = 0;
+    virtual void close() = 0;
+    virtual void update() = 0;
+
+    virtual bool isConnected() = 0;
+    virtual bool isFrameNew() = 0;
+
+    virtual int getWidth() = 0;
+    virtual int getHeight() = 0;
+
+    // 8-bit depth (near = white), raw 16-bit depth in mm, and the RGB image
+    virtual ofPixels & getDepthPixels() = 0;
+    virtual ofShortPixels & getRawDepthPixels() = 0;
+    virtual ofPixels & getPixels() = 0;
+
+    // capture time of the current frame in microseconds
+    virtual uint64_t getFrameTimestamp() = 0;
+
+    // depth camera intrinsics, as reported by libfreenect
+    virtual float getZeroPlanePixelSize() = 0;
+    virtual float getZeroPlaneDistance() = 0;
+
+    virtual ofVec3f getWorldCoordinateAt(int x, int y) = 0;
+    virtual ofVec3f getWorldCoordinateAt(float cx, float cy, float wz) = 0;
+
+};
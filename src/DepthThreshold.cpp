@@ -0,0 +1,672 @@
+#include "DepthThreshold.h"
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define DEPTH_THRESHOLD_X86
+    #include <emmintrin.h>
+    #if defined(__GNUC__)
+        // AVX2 is compiled per function and only used if the CPU reports it
+        #define DEPTH_THRESHOLD_AVX2
+        #include <immintrin.h>
+    #endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define DEPTH_THRESHOLD_NEON
+    #include <arm_neon.h>
+#endif
+
+
+namespace DepthThreshold {
+
+    enum InstructionSet { SCALAR, SSE2, AVX2, NEON };
+
+    static InstructionSet detectInstructionSet(){
+#if defined(DEPTH_THRESHOLD_AVX2)
+        if (__builtin_cpu_supports("avx2")) return AVX2;
+#endif
+#if defined(DEPTH_THRESHOLD_X86)
+        return SSE2;
+#elif defined(DEPTH_THRESHOLD_NEON)
+        return NEON;
+#else
+        return SCALAR;
+#endif
+    }
+
+    static InstructionSet getBest(){
+        static const InstructionSet best = detectInstructionSet();
+        return best;
+    }
+
+    const char * getInstructionSet(){
+        switch (getBest()){
+            case AVX2: return "avx2";
+            case SSE2: return "sse2";
+            case NEON: return "neon";
+            default: return "scalar";
+        }
+    }
+
+    //--------------------------------------------------------------
+    // far < x <= near, as the two cvThreshold calls and cvAnd this replaced kept it, is the same
+    // as lo <= x <= hi with lo = far + 1, hi = near, which unsigned SIMD can test as
+    // min(max(x, lo), hi) == x without any sign tricks.
+
+    void bandScalar(const unsigned char * src, unsigned char * dst, size_t numPixels, int nearThreshold, int farThreshold, const unsigned char * mask){
+        for (size_t i=0; i<numPixels; i++){
+            unsigned char keep = mask ? mask[i] : 255;
+            dst[i] = (src[i] <= nearThreshold && src[i] > farThreshold) ? keep : 0;
+        }
+    }
+
+#if defined(DEPTH_THRESHOLD_X86)
+    static size_t bandSSE2(const unsigned char * src, unsigned char * dst, size_t numPixels, unsigned char lo, unsigned char hi, const unsigned char * mask){
+        const __m128i vlo = _mm_set1_epi8((char)lo);
+        const __m128i vhi = _mm_set1_epi8((char)hi);
+        size_t i = 0;
+        for (; i + 16 <= numPixels; i += 16){
+            __m128i x = _mm_loadu_si128((const __m128i *)(src + i));
+            __m128i clamped = _mm_min_epu8(_mm_max_epu8(x, vlo), vhi);
+            __m128i result = _mm_cmpeq_epi8(clamped, x);
+            if (mask) result = _mm_and_si128(result, _mm_loadu_si128((const __m128i *)(mask + i)));
+            _mm_storeu_si128((__m128i *)(dst + i), result);
+        }
+        return i;
+    }
+#endif
+
+#if defined(DEPTH_THRESHOLD_AVX2)
+    __attribute__((target("avx2")))
+    static size_t bandAVX2(const unsigned char * src, unsigned char * dst, size_t numPixels, unsigned char lo, unsigned char hi, const unsigned char * mask){
+        const __m256i vlo = _mm256_set1_epi8((char)lo);
+        const __m256i vhi = _mm256_set1_epi8((char)hi);
+        size_t i = 0;
+        for (; i + 32 <= numPixels; i += 32){
+            __m256i x = _mm256_loadu_si256((const __m256i *)(src + i));
+            __m256i clamped = _mm256_min_epu8(_mm256_max_epu8(x, vlo), vhi);
+            __m256i result = _mm256_cmpeq_epi8(clamped, x);
+            if (mask) result = _mm256_and_si256(result, _mm256_loadu_si256((const __m256i *)(mask + i)));
+            _mm256_storeu_si256((__m256i *)(dst + i), result);
+        }
+        return i;
+    }
+#endif
+
+#if defined(DEPTH_THRESHOLD_NEON)
+    static size_t bandNEON(const unsigned char * src, unsigned char * dst, size_t numPixels, unsigned char lo, unsigned char hi, const unsigned char * mask){
+        const uint8x16_t vlo = vdupq_n_u8(lo);
+        const uint8x16_t vhi = vdupq_n_u8(hi);
+        size_t i = 0;
+        for (; i + 16 <= numPixels; i += 16){
+            uint8x16_t x = vld1q_u8(src + i);
+            uint8x16_t result = vandq_u8(vcgeq_u8(x, vlo), vcleq_u8(x, vhi));
+            if (mask) result = vandq_u8(result, vld1q_u8(mask + i));
+            vst1q_u8(dst + i, result);
+        }
+        return i;
+    }
+#endif
+
+    void band(const unsigned char * src, unsigned char * dst, size_t numPixels, int nearThreshold, int farThreshold, const unsigned char * mask){
+
+        // empty band, nothing can pass
+        if (nearThreshold <= farThreshold || nearThreshold < 0 || farThreshold >= 255){
+            memset(dst, 0, numPixels);
+            return;
+        }
+
+        unsigned char lo = farThreshold < 0 ? 0 : farThreshold + 1;
+        unsigned char hi = nearThreshold > 255 ? 255 : nearThreshold;
+
+        size_t done = 0;
+        switch (getBest()){
+#if defined(DEPTH_THRESHOLD_AVX2)
+            case AVX2: done = bandAVX2(src, dst, numPixels, lo, hi, mask); break;
+#endif
+#if defined(DEPTH_THRESHOLD_X86)
+            case SSE2: done = bandSSE2(src, dst, numPixels, lo, hi, mask); break;
+#endif
+#if defined(DEPTH_THRESHOLD_NEON)
+            case NEON: done = bandNEON(src, dst, numPixels, lo, hi, mask); break;
+#endif
+            default: break;
+        }
+
+        bandScalar(src + done, dst + done, numPixels - done, nearThreshold, farThreshold, mask ? mask + done : NULL);
+    }
+
+    //--------------------------------------------------------------
+    // 16-bit millimetre band. SSE2 has no unsigned 16-bit min/max, so lo <= x <= hi is tested
+    // with saturating subtracts instead: (lo -sat x) == 0 && (x -sat hi) == 0. The two 16-bit
+    // masks are then packed down to one byte per pixel.
+
+    void bandRawScalar(const unsigned short * src, unsigned char * dst, size_t numPixels, int nearMm, int farMm, const unsigned char * mask){
+        // 0 means no reading, it never passes however near the band starts
+        if (nearMm < 0) nearMm = 0;
+        for (size_t i=0; i<numPixels; i++){
+            unsigned char keep = mask ? mask[i] : 255;
+            dst[i] = (src[i] != 0 && src[i] > nearMm && src[i] < farMm) ? keep : 0;
+        }
+    }
+
+#if defined(DEPTH_THRESHOLD_X86)
+    static inline __m128i inRangeSSE2(__m128i x, __m128i lo, __m128i hi){
+        const __m128i zero = _mm_setzero_si128();
+        return _mm_and_si128(_mm_cmpeq_epi16(_mm_subs_epu16(lo, x), zero), _mm_cmpeq_epi16(_mm_subs_epu16(x, hi), zero));
+    }
+
+    static size_t bandRawSSE2(const unsigned short * src, unsigned char * dst, size_t numPixels, unsigned short lo, unsigned short hi, const unsigned char * mask){
+        const __m128i vlo = _mm_set1_epi16((short)lo);
+        const __m128i vhi = _mm_set1_epi16((short)hi);
+        size_t i = 0;
+        for (; i + 16 <= numPixels; i += 16){
+            __m128i a = inRangeSSE2(_mm_loadu_si128((const __m128i *)(src + i)), vlo, vhi);
+            __m128i b = inRangeSSE2(_mm_loadu_si128((const __m128i *)(src + i + 8)), vlo, vhi);
+            __m128i result = _mm_packs_epi16(a, b);
+            if (mask) result = _mm_and_si128(result, _mm_loadu_si128((const __m128i *)(mask + i)));
+            _mm_storeu_si128((__m128i *)(dst + i), result);
+        }
+        return i;
+    }
+#endif
+
+#if defined(DEPTH_THRESHOLD_AVX2)
+    __attribute__((target("avx2")))
+    static inline __m256i inRangeAVX2(__m256i x, __m256i lo, __m256i hi){
+        return _mm256_cmpeq_epi16(_mm256_min_epu16(_mm256_max_epu16(x, lo), hi), x);
+    }
+
+    __attribute__((target("avx2")))
+    static size_t bandRawAVX2(const unsigned short * src, unsigned char * dst, size_t numPixels, unsigned short lo, unsigned short hi, const unsigned char * mask){
+        const __m256i vlo = _mm256_set1_epi16((short)lo);
+        const __m256i vhi = _mm256_set1_epi16((short)hi);
+        size_t i = 0;
+        for (; i + 32 <= numPixels; i += 32){
+            __m256i a = inRangeAVX2(_mm256_loadu_si256((const __m256i *)(src + i)), vlo, vhi);
+            __m256i b = inRangeAVX2(_mm256_loadu_si256((const __m256i *)(src + i + 16)), vlo, vhi);
+            // packs works per 128-bit lane, put the quadwords back in pixel order
+            __m256i result = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xD8);
+            if (mask) result = _mm256_and_si256(result, _mm256_loadu_si256((const __m256i *)(mask + i)));
+            _mm256_storeu_si256((__m256i *)(dst + i), result);
+        }
+        return i;
+    }
+#endif
+
+#if defined(DEPTH_THRESHOLD_NEON)
+    static size_t bandRawNEON(const unsigned short * src, unsigned char * dst, size_t numPixels, unsigned short lo, unsigned short hi, const unsigned char * mask){
+        const uint16x8_t vlo = vdupq_n_u16(lo);
+        const uint16x8_t vhi = vdupq_n_u16(hi);
+        size_t i = 0;
+        for (; i + 16 <= numPixels; i += 16){
+            uint16x8_t a = vld1q_u16(src + i);
+            uint16x8_t b = vld1q_u16(src + i + 8);
+            uint16x8_t ma = vandq_u16(vcgeq_u16(a, vlo), vcleq_u16(a, vhi));
+            uint16x8_t mb = vandq_u16(vcgeq_u16(b, vlo), vcleq_u16(b, vhi));
+            uint8x16_t result = vcombine_u8(vmovn_u16(ma), vmovn_u16(mb));
+            if (mask) result = vandq_u8(result, vld1q_u8(mask + i));
+            vst1q_u8(dst + i, result);
+        }
+        return i;
+    }
+#endif
+
+    void bandRaw(const unsigned short * src, unsigned char * dst, size_t numPixels, int nearMm, int farMm, const unsigned char * mask){
+
+        // empty band, nothing can pass
+        if (farMm - nearMm < 2 || farMm <= 0 || nearMm >= 65535){
+            memset(dst, 0, numPixels);
+            return;
+        }
+
+        // 0 means no reading, so the band never starts below 1mm
+        unsigned short lo = nearMm < 0 ? 1 : nearMm + 1;
+        unsigned short hi = farMm > 65535 ? 65535 : farMm - 1;
+
+        size_t done = 0;
+        switch (getBest()){
+#if defined(DEPTH_THRESHOLD_AVX2)
+            case AVX2: done = bandRawAVX2(src, dst, numPixels, lo, hi, mask); break;
+#endif
+#if defined(DEPTH_THRESHOLD_X86)
+            case SSE2: done = bandRawSSE2(src, dst, numPixels, lo, hi, mask); break;
+#endif
+#if defined(DEPTH_THRESHOLD_NEON)
+            case NEON: done = bandRawNEON(src, dst, numPixels, lo, hi, mask); break;
+#endif
+            default: break;
+        }
+
+        bandRawScalar(src + done, dst + done, numPixels - done, nearMm, farMm, mask ? mask + done : NULL);
+    }
+
+    //--------------------------------------------------------------
+    // Height above a learned background: h = background -sat depth, then the same in-range test
+    // as the raw band, with pixels missing a reading in either image knocked out.
+
+    void heightBandScalar(const unsigned short * src, const unsigned short * background, unsigned char * dst, size_t numPixels, int minMm, int maxMm, const unsigned char * mask){
+        for (size_t i=0; i<numPixels; i++){
+            unsigned char keep = mask ? mask[i] : 255;
+            int height = src[i] < background[i] ? background[i] - src[i] : 0;
+            bool valid = src[i] != 0 && background[i] != 0;
+            dst[i] = (valid && height >= minMm && height <= maxMm) ? keep : 0;
+        }
+    }
+
+#if defined(DEPTH_THRESHOLD_X86)
+    static inline __m128i heightInRangeSSE2(__m128i depth, __m128i background, __m128i lo, __m128i hi){
+        const __m128i zero = _mm_setzero_si128();
+        __m128i invalid = _mm_or_si128(_mm_cmpeq_epi16(depth, zero), _mm_cmpeq_epi16(background, zero));
+        return _mm_andnot_si128(invalid, inRangeSSE2(_mm_subs_epu16(background, depth), lo, hi));
+    }
+
+    static size_t heightBandSSE2(const unsigned short * src, const unsigned short * background, unsigned char * dst, size_t numPixels, unsigned short lo, unsigned short hi, const unsigned char * mask){
+        const __m128i vlo = _mm_set1_epi16((short)lo);
+        const __m128i vhi = _mm_set1_epi16((short)hi);
+        size_t i = 0;
+        for (; i + 16 <= numPixels; i += 16){
+            __m128i a = heightInRangeSSE2(_mm_loadu_si128((const __m128i *)(src + i)), _mm_loadu_si128((const __m128i *)(background + i)), vlo, vhi);
+            __m128i b = heightInRangeSSE2(_mm_loadu_si128((const __m128i *)(src + i + 8)), _mm_loadu_si128((const __m128i *)(background + i + 8)), vlo, vhi);
+            __m128i result = _mm_packs_epi16(a, b);
+            if (mask) result = _mm_and_si128(result, _mm_loadu_si128((const __m128i *)(mask + i)));
+            _mm_storeu_si128((__m128i *)(dst + i), result);
+        }
+        return i;
+    }
+#endif
+
+#if defined(DEPTH_THRESHOLD_AVX2)
+    __attribute__((target("avx2")))
+    static inline __m256i heightInRangeAVX2(__m256i depth, __m256i background, __m256i lo, __m256i hi){
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i invalid = _mm256_or_si256(_mm256_cmpeq_epi16(depth, zero), _mm256_cmpeq_epi16(background, zero));
+        return _mm256_andnot_si256(invalid, inRangeAVX2(_mm256_subs_epu16(background, depth), lo, hi));
+    }
+
+    __attribute__((target("avx2")))
+    static size_t heightBandAVX2(const unsigned short * src, const unsigned short * background, unsigned char * dst, size_t numPixels, unsigned short lo, unsigned short hi, const unsigned char * mask){
+        const __m256i vlo = _mm256_set1_epi16((short)lo);
+        const __m256i vhi = _mm256_set1_epi16((short)hi);
+        size_t i = 0;
+        for (; i + 32 <= numPixels; i += 32){
+            __m256i a = heightInRangeAVX2(_mm256_loadu_si256((const __m256i *)(src + i)), _mm256_loadu_si256((const __m256i *)(background + i)), vlo, vhi);
+            __m256i b = heightInRangeAVX2(_mm256_loadu_si256((const __m256i *)(src + i + 16)), _mm256_loadu_si256((const __m256i *)(background + i + 16)), vlo, vhi);
+            __m256i result = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xD8);
+            if (mask) result = _mm256_and_si256(result, _mm256_loadu_si256((const __m256i *)(mask + i)));
+            _mm256_storeu_si256((__m256i *)(dst + i), result);
+        }
+        return i;
+    }
+#endif
+
+#if defined(DEPTH_THRESHOLD_NEON)
+    static inline uint16x8_t heightInRangeNEON(uint16x8_t depth, uint16x8_t background, uint16x8_t lo, uint16x8_t hi){
+        uint16x8_t height = vqsubq_u16(background, depth);
+        uint16x8_t valid = vandq_u16(vtstq_u16(depth, depth), vtstq_u16(background, background));
+        return vandq_u16(valid, vandq_u16(vcgeq_u16(height, lo), vcleq_u16(height, hi)));
+    }
+
+    static size_t heightBandNEON(const unsigned short * src, const unsigned short * background, unsigned char * dst, size_t numPixels, unsigned short lo, unsigned short hi, const unsigned char * mask){
+        const uint16x8_t vlo = vdupq_n_u16(lo);
+        const uint16x8_t vhi = vdupq_n_u16(hi);
+        size_t i = 0;
+        for (; i + 16 <= numPixels; i += 16){
+            uint16x8_t a = heightInRangeNEON(vld1q_u16(src + i), vld1q_u16(background + i), vlo, vhi);
+            uint16x8_t b = heightInRangeNEON(vld1q_u16(src + i + 8), vld1q_u16(background + i + 8), vlo, vhi);
+            uint8x16_t result = vcombine_u8(vmovn_u16(a), vmovn_u16(b));
+            if (mask) result = vandq_u8(result, vld1q_u8(mask + i));
+            vst1q_u8(dst + i, result);
+        }
+        return i;
+    }
+#endif
+
+    void heightBand(const unsigned short * src, const unsigned short * background, unsigned char * dst, size_t numPixels, int minMm, int maxMm, const unsigned char * mask){
+
+        // empty band, nothing can pass
+        if (maxMm < minMm || maxMm < 0 || minMm > 65535){
+            memset(dst, 0, numPixels);
+            return;
+        }
+
+        unsigned short lo = minMm < 0 ? 0 : minMm;
+        unsigned short hi = maxMm > 65535 ? 65535 : maxMm;
+
+        size_t done = 0;
+        switch (getBest()){
+#if defined(DEPTH_THRESHOLD_AVX2)
+            case AVX2: done = heightBandAVX2(src, background, dst, numPixels, lo, hi, mask); break;
+#endif
+#if defined(DEPTH_THRESHOLD_X86)
+            case SSE2: done = heightBandSSE2(src, background, dst, numPixels, lo, hi, mask); break;
+#endif
+#if defined(DEPTH_THRESHOLD_NEON)
+            case NEON: done = heightBandNEON(src, background, dst, numPixels, lo, hi, mask); break;
+#endif
+            default: break;
+        }
+
+        heightBandScalar(src + done, background + done, dst + done, numPixels - done, lo, hi, mask ? mask + done : NULL);
+    }
+
+
+    //--------------------------------------------------------------
+    // Height above a plane: with the per-pixel ray folded into coeff, it's one multiply-add per
+    // pixel in float, rounded to nearest and narrowed to 16 bits with a saturating pack.
+
+    void planeHeightScalar(const unsigned short * src, const float * coeff, float offset, short * dst, size_t numPixels){
+        for (size_t i=0; i<numPixels; i++){
+            float h = rintf(coeff[i] * src[i] + offset);
+            h = h < -32767 ? -32767 : (h > 32767 ? 32767 : h);
+            dst[i] = src[i] ? (short)h : NO_HEIGHT;
+        }
+    }
+
+#if defined(DEPTH_THRESHOLD_X86)
+    static inline __m128i planeHeightSSE2(const unsigned short * src, const float * coeff, __m128 offset){
+        const __m128i zero = _mm_setzero_si128();
+        __m128i depth = _mm_loadu_si128((const __m128i *)src);
+        __m128 lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(depth, zero));
+        __m128 hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(depth, zero));
+        __m128i a = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(lo, _mm_loadu_ps(coeff)), offset));
+        __m128i b = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(hi, _mm_loadu_ps(coeff + 4)), offset));
+        __m128i h = _mm_max_epi16(_mm_packs_epi32(a, b), _mm_set1_epi16(-32767));
+        __m128i invalid = _mm_cmpeq_epi16(depth, zero);
+        return _mm_or_si128(_mm_andnot_si128(invalid, h), _mm_and_si128(invalid, _mm_set1_epi16(NO_HEIGHT)));
+    }
+
+    static size_t planeHeightSSE2(const unsigned short * src, const float * coeff, float offset, short * dst, size_t numPixels){
+        const __m128 voffset = _mm_set1_ps(offset);
+        size_t i = 0;
+        for (; i + 8 <= numPixels; i += 8)
+            _mm_storeu_si128((__m128i *)(dst + i), planeHeightSSE2(src + i, coeff + i, voffset));
+        return i;
+    }
+#endif
+
+#if defined(DEPTH_THRESHOLD_AVX2)
+    __attribute__((target("avx2")))
+    static size_t planeHeightAVX2(const unsigned short * src, const float * coeff, float offset, short * dst, size_t numPixels){
+        const __m256 voffset = _mm256_set1_ps(offset);
+        const __m256i zero = _mm256_setzero_si256();
+        size_t i = 0;
+        for (; i + 16 <= numPixels; i += 16){
+            __m256i depth = _mm256_loadu_si256((const __m256i *)(src + i));
+            __m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(src + i))));
+            __m256 hi = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(src + i + 8))));
+            __m256i a = _mm256_cvtps_epi32(_mm256_add_ps(_mm256_mul_ps(lo, _mm256_loadu_ps(coeff + i)), voffset));
+            __m256i b = _mm256_cvtps_epi32(_mm256_add_ps(_mm256_mul_ps(hi, _mm256_loadu_ps(coeff + i + 8)), voffset));
+            // packs works within 128-bit lanes, the permute puts the pixels back in order
+            __m256i h = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+            h = _mm256_max_epi16(h, _mm256_set1_epi16(-32767));
+            __m256i invalid = _mm256_cmpeq_epi16(depth, zero);
+            h = _mm256_blendv_epi8(h, _mm256_set1_epi16(NO_HEIGHT), invalid);
+            _mm256_storeu_si256((__m256i *)(dst + i), h);
+        }
+        return i;
+    }
+#endif
+
+#if defined(DEPTH_THRESHOLD_NEON) && defined(__aarch64__)
+    // round to nearest conversion (vcvtnq) is ARMv8 only, 32-bit ARM takes the scalar path
+    static size_t planeHeightNEON(const unsigned short * src, const float * coeff, float offset, short * dst, size_t numPixels){
+        const float32x4_t voffset = vdupq_n_f32(offset);
+        size_t i = 0;
+        for (; i + 8 <= numPixels; i += 8){
+            uint16x8_t depth = vld1q_u16(src + i);
+            float32x4_t lo = vcvtq_f32_u32(vmovl_u16(vget_low_u16(depth)));
+            float32x4_t hi = vcvtq_f32_u32(vmovl_u16(vget_high_u16(depth)));
+            int32x4_t a = vcvtnq_s32_f32(vmlaq_f32(voffset, lo, vld1q_f32(coeff + i)));
+            int32x4_t b = vcvtnq_s32_f32(vmlaq_f32(voffset, hi, vld1q_f32(coeff + i + 4)));
+            int16x8_t h = vmaxq_s16(vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)), vdupq_n_s16(-32767));
+            uint16x8_t valid = vtstq_u16(depth, depth);
+            vst1q_s16(dst + i, vbslq_s16(valid, h, vdupq_n_s16(NO_HEIGHT)));
+        }
+        return i;
+    }
+#endif
+
+    void planeHeight(const unsigned short * src, const float * coeff, float offset, short * dst, size_t numPixels){
+
+        size_t done = 0;
+        switch (getBest()){
+#if defined(DEPTH_THRESHOLD_AVX2)
+            case AVX2: done = planeHeightAVX2(src, coeff, offset, dst, numPixels); break;
+#endif
+#if defined(DEPTH_THRESHOLD_X86)
+            case SSE2: done = planeHeightSSE2(src, coeff, offset, dst, numPixels); break;
+#endif
+#if defined(DEPTH_THRESHOLD_NEON) && defined(__aarch64__)
+            case NEON: done = planeHeightNEON(src, coeff, offset, dst, numPixels); break;
+#endif
+            default: break;
+        }
+
+        planeHeightScalar(src + done, coeff + done, offset, dst + done, numPixels - done);
+    }
+
+    //--------------------------------------------------------------
+    // Signed height range. Heights are signed 16-bit, so plain signed compares do it:
+    // in range = !(h < lo) && !(h > hi). NO_HEIGHT is below any lo the callers pass.
+
+    void heightRangeScalar(const short * height, unsigned char * dst, size_t numPixels, int minMm, int maxMm, const unsigned char * mask){
+        for (size_t i=0; i<numPixels; i++){
+            unsigned char keep = mask ? mask[i] : 255;
+            dst[i] = (height[i] != NO_HEIGHT && height[i] >= minMm && height[i] <= maxMm) ? keep : 0;
+        }
+    }
+
+#if defined(DEPTH_THRESHOLD_X86)
+    static inline __m128i heightRangeSSE2(__m128i h, __m128i lo, __m128i hi){
+        return _mm_andnot_si128(_mm_or_si128(_mm_cmplt_epi16(h, lo), _mm_cmpgt_epi16(h, hi)), _mm_set1_epi16(-1));
+    }
+
+    static size_t heightRangeSSE2(const short * height, unsigned char * dst, size_t numPixels, short lo, short hi, const unsigned char * mask){
+        const __m128i vlo = _mm_set1_epi16(lo);
+        const __m128i vhi = _mm_set1_epi16(hi);
+        size_t i = 0;
+        for (; i + 16 <= numPixels; i += 16){
+            __m128i a = heightRangeSSE2(_mm_loadu_si128((const __m128i *)(height + i)), vlo, vhi);
+            __m128i b = heightRangeSSE2(_mm_loadu_si128((const __m128i *)(height + i + 8)), vlo, vhi);
+            __m128i result = _mm_packs_epi16(a, b);
+            if (mask) result = _mm_and_si128(result, _mm_loadu_si128((const __m128i *)(mask + i)));
+            _mm_storeu_si128((__m128i *)(dst + i), result);
+        }
+        return i;
+    }
+#endif
+
+#if defined(DEPTH_THRESHOLD_AVX2)
+    __attribute__((target("avx2")))
+    static inline __m256i heightRangeAVX2(__m256i h, __m256i lo, __m256i hi){
+        // no cmplt for 16-bit on AVX2, h < lo is lo > h
+        return _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpgt_epi16(lo, h), _mm256_cmpgt_epi16(h, hi)), _mm256_set1_epi16(-1));
+    }
+
+    __attribute__((target("avx2")))
+    static size_t heightRangeAVX2(const short * height, unsigned char * dst, size_t numPixels, short lo, short hi, const unsigned char * mask){
+        const __m256i vlo = _mm256_set1_epi16(lo);
+        const __m256i vhi = _mm256_set1_epi16(hi);
+        size_t i = 0;
+        for (; i + 32 <= numPixels; i += 32){
+            __m256i a = heightRangeAVX2(_mm256_loadu_si256((const __m256i *)(height + i)), vlo, vhi);
+            __m256i b = heightRangeAVX2(_mm256_loadu_si256((const __m256i *)(height + i + 16)), vlo, vhi);
+            __m256i result = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xD8);
+            if (mask) result = _mm256_and_si256(result, _mm256_loadu_si256((const __m256i *)(mask + i)));
+            _mm256_storeu_si256((__m256i *)(dst + i), result);
+        }
+        return i;
+    }
+#endif
+
+#if defined(DEPTH_THRESHOLD_NEON)
+    static size_t heightRangeNEON(const short * height, unsigned char * dst, size_t numPixels, short lo, short hi, const unsigned char * mask){
+        const int16x8_t vlo = vdupq_n_s16(lo);
+        const int16x8_t vhi = vdupq_n_s16(hi);
+        size_t i = 0;
+        for (; i + 16 <= numPixels; i += 16){
+            int16x8_t ha = vld1q_s16(height + i);
+            int16x8_t hb = vld1q_s16(height + i + 8);
+            uint16x8_t a = vandq_u16(vcgeq_s16(ha, vlo), vcleq_s16(ha, vhi));
+            uint16x8_t b = vandq_u16(vcgeq_s16(hb, vlo), vcleq_s16(hb, vhi));
+            uint8x16_t result = vcombine_u8(vmovn_u16(a), vmovn_u16(b));
+            if (mask) result = vandq_u8(result, vld1q_u8(mask + i));
+            vst1q_u8(dst + i, result);
+        }
+        return i;
+    }
+#endif
+
+    void heightRange(const short * height, unsigned char * dst, size_t numPixels, int minMm, int maxMm, const unsigned char * mask){
+
+        // keep NO_HEIGHT out of the range
+        short lo = minMm <= NO_HEIGHT ? NO_HEIGHT + 1 : (minMm > 32767 ? 32767 : minMm);
+        short hi = maxMm > 32767 ? 32767 : (maxMm < NO_HEIGHT ? NO_HEIGHT : maxMm);
+
+        // empty range, nothing can pass
+        if (maxMm < minMm || minMm > 32767 || maxMm <= NO_HEIGHT){
+            memset(dst, 0, numPixels);
+            return;
+        }
+
+        size_t done = 0;
+        switch (getBest()){
+#if defined(DEPTH_THRESHOLD_AVX2)
+            case AVX2: done = heightRangeAVX2(height, dst, numPixels, lo, hi, mask); break;
+#endif
+#if defined(DEPTH_THRESHOLD_X86)
+            case SSE2: done = heightRangeSSE2(height, dst, numPixels, lo, hi, mask); break;
+#endif
+#if defined(DEPTH_THRESHOLD_NEON)
+            case NEON: done = heightRangeNEON(height, dst, numPixels, lo, hi, mask); break;
+#endif
+            default: break;
+        }
+
+        heightRangeScalar(height + done, dst + done, numPixels - done, lo, hi, mask ? mask + done : NULL);
+    }
+
+    //--------------------------------------------------------------
+    // Pixels that changed by more than a noise floor. |a - b| is the OR of the two saturating
+    // subtracts, the floor comes off with one more, and every lane still above zero with a
+    // reading on both sides subtracts its all-ones mask (-1) from a 16-bit counter. The counters
+    // are summed out before they can overflow.
+
+    size_t countChangedScalar(const unsigned short * a, const unsigned short * b, size_t numPixels, int noiseMm){
+        size_t count = 0;
+        for (size_t i=0; i<numPixels; i++){
+            if (a[i] == 0 || b[i] == 0) continue;
+            count += abs((int)a[i] - (int)b[i]) > noiseMm;
+        }
+        return count;
+    }
+
+    // iterations before a 16-bit counter lane could overflow as a signed value
+    static const size_t COUNT_BLOCK = 32767;
+
+#if defined(DEPTH_THRESHOLD_X86)
+    static size_t countChangedSSE2(const unsigned short * a, const unsigned short * b, size_t numPixels, unsigned short noise, size_t & count){
+        const __m128i vnoise = _mm_set1_epi16((short)noise);
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i ones = _mm_set1_epi16(1);
+        const __m128i allOnes = _mm_set1_epi16(-1);
+        count = 0;
+        size_t i = 0;
+        while (i + 8 <= numPixels){
+            size_t blockEnd = i + std::min(numPixels - i, COUNT_BLOCK * 8);
+            __m128i counts = zero;
+            for (; i + 8 <= blockEnd; i += 8){
+                __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+                __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+                __m128i diff = _mm_or_si128(_mm_subs_epu16(x, y), _mm_subs_epu16(y, x));
+                __m128i excess = _mm_subs_epu16(diff, vnoise);
+                __m128i unchanged = _mm_or_si128(_mm_cmpeq_epi16(excess, zero),
+                    _mm_or_si128(_mm_cmpeq_epi16(x, zero), _mm_cmpeq_epi16(y, zero)));
+                counts = _mm_sub_epi16(counts, _mm_andnot_si128(unchanged, allOnes));
+            }
+            int32_t sums[4];
+            _mm_storeu_si128((__m128i *)sums, _mm_madd_epi16(counts, ones));
+            count += sums[0] + sums[1] + sums[2] + sums[3];
+        }
+        return i;
+    }
+#endif
+
+#if defined(DEPTH_THRESHOLD_AVX2)
+    __attribute__((target("avx2")))
+    static size_t countChangedAVX2(const unsigned short * a, const unsigned short * b, size_t numPixels, unsigned short noise, size_t & count){
+        const __m256i vnoise = _mm256_set1_epi16((short)noise);
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i ones = _mm256_set1_epi16(1);
+        const __m256i allOnes = _mm256_set1_epi16(-1);
+        count = 0;
+        size_t i = 0;
+        while (i + 16 <= numPixels){
+            size_t blockEnd = i + std::min(numPixels - i, COUNT_BLOCK * 16);
+            __m256i counts = zero;
+            for (; i + 16 <= blockEnd; i += 16){
+                __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+                __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+                __m256i diff = _mm256_or_si256(_mm256_subs_epu16(x, y), _mm256_subs_epu16(y, x));
+                __m256i excess = _mm256_subs_epu16(diff, vnoise);
+                __m256i unchanged = _mm256_or_si256(_mm256_cmpeq_epi16(excess, zero),
+                    _mm256_or_si256(_mm256_cmpeq_epi16(x, zero), _mm256_cmpeq_epi16(y, zero)));
+                counts = _mm256_sub_epi16(counts, _mm256_andnot_si256(unchanged, allOnes));
+            }
+            int32_t sums[8];
+            _mm256_storeu_si256((__m256i *)sums, _mm256_madd_epi16(counts, ones));
+            for (int k=0; k<8; k++)
+                count += sums[k];
+        }
+        return i;
+    }
+#endif
+
+#if defined(DEPTH_THRESHOLD_NEON)
+    static size_t countChangedNEON(const unsigned short * a, const unsigned short * b, size_t numPixels, unsigned short noise, size_t & count){
+        const uint16x8_t vnoise = vdupq_n_u16(noise);
+        const uint16x8_t zero = vdupq_n_u16(0);
+        count = 0;
+        size_t i = 0;
+        while (i + 8 <= numPixels){
+            size_t blockEnd = i + std::min(numPixels - i, COUNT_BLOCK * 8);
+            uint16x8_t counts = zero;
+            for (; i + 8 <= blockEnd; i += 8){
+                uint16x8_t x = vld1q_u16(a + i);
+                uint16x8_t y = vld1q_u16(b + i);
+                uint16x8_t excess = vqsubq_u16(vabdq_u16(x, y), vnoise);
+                uint16x8_t missing = vorrq_u16(vceqq_u16(x, zero), vceqq_u16(y, zero));
+                counts = vsubq_u16(counts, vbicq_u16(vtstq_u16(excess, excess), missing));
+            }
+            uint64x2_t total = vpaddlq_u32(vpaddlq_u16(counts));
+            count += vgetq_lane_u64(total, 0) + vgetq_lane_u64(total, 1);
+        }
+        return i;
+    }
+#endif
+
+    size_t countChanged(const unsigned short * a, const unsigned short * b, size_t numPixels, int noiseMm){
+
+        unsigned short noise = noiseMm < 0 ? 0 : (noiseMm > 65535 ? 65535 : noiseMm);
+
+        size_t count = 0;
+        size_t done = 0;
+        switch (getBest()){
+#if defined(DEPTH_THRESHOLD_AVX2)
+            case AVX2: done = countChangedAVX2(a, b, numPixels, noise, count); break;
+#endif
+#if defined(DEPTH_THRESHOLD_X86)
+            case SSE2: done = countChangedSSE2(a, b, numPixels, noise, count); break;
+#endif
+#if defined(DEPTH_THRESHOLD_NEON)
+            case NEON: done = countChangedNEON(a, b, numPixels, noise, count); break;
+#endif
+            default: break;
+        }
+
+        return count + countChangedScalar(a + done, b + done, numPixels - done, noise);
+    }
+
+}
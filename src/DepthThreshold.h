@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Vectorised depth segmentation kernels.
+// Each kernel has SSE2 / AVX2 / NEON paths and a scalar fallback; the best one for the
+// running CPU is picked on first use. The 8-bit kernels can run in place (src == dst).
+// An optional mask (0 or 255 per pixel) is ANDed into the result in the same pass.
+
+namespace DepthThreshold {
+
+    // dst = 255 where far < src <= near, 0 elsewhere (8-bit depth, near = white)
+    void band(const unsigned char * src, unsigned char * dst, size_t numPixels, int nearThreshold, int farThreshold, const unsigned char * mask = NULL);
+
+    // dst = 255 where nearMm < src < farMm (raw 16-bit depth in millimetres, 0 = no reading)
+    void bandRaw(const unsigned short * src, unsigned char * dst, size_t numPixels, int nearMm, int farMm, const unsigned char * mask = NULL);
+
+    // dst = 255 where minMm <= background - src <= maxMm, i.e. the pixel sits within the given
+    // height above a learned per-pixel surface. Pixels with no reading in either image never pass,
+    // and anything at or below the surface counts as height 0.
+    void heightBand(const unsigned short * src, const unsigned short * background, unsigned char * dst, size_t numPixels, int minMm, int maxMm, const unsigned char * mask = NULL);
+
+    // dst = round(coeff * src + offset) as signed mm, the distance of each pixel from a plane
+    // (see HeightMap), saturated to +-32767. Pixels with no reading get NO_HEIGHT.
+    void planeHeight(const unsigned short * src, const float * coeff, float offset, short * dst, size_t numPixels);
+
+    // dst = 255 where minMm <= height <= maxMm, for the signed heights planeHeight() produces
+    void heightRange(const short * height, unsigned char * dst, size_t numPixels, int minMm, int maxMm, const unsigned char * mask = NULL);
+
+    const short NO_HEIGHT = -32768;
+
+    // number of pixels that differ by more than noiseMm between two raw 16-bit depth images;
+    // pixels with no reading in either image don't count (see FrameGate)
+    size_t countChanged(const unsigned short * a, const unsigned short * b, size_t numPixels, int noiseMm);
+
+    // reference implementations, also used for the tail of each SIMD loop
+    void bandScalar(const unsigned char * src, unsigned char * dst, size_t numPixels, int nearThreshold, int farThreshold, const unsigned char * mask = NULL);
+    void bandRawScalar(const unsigned short * src, unsigned char * dst, size_t numPixels, int nearMm, int farMm, const unsigned char * mask = NULL);
+    void heightBandScalar(const unsigned short * src, const unsigned short * background, unsigned char * dst, size_t numPixels, int minMm, int maxMm, const unsigned char * mask = NULL);
+    void planeHeightScalar(const unsigned short * src, const float * coeff, float offset, short * dst, size_t numPixels);
+    void heightRangeScalar(const short * height, unsigned char * dst, size_t numPixels, int minMm, int maxMm, const unsigned char * mask = NULL);
+    size_t countChangedScalar(const unsigned short * a, const unsigned short * b, size_t numPixels, int noiseMm);
+
+    // name of the instruction set the kernels dispatch to ("avx2", "sse2", "neon" or "scalar")
+    const char * getInstructionSet();
+
+}
@@ -0,0 +1,81 @@
+#include "FingertipDetector.h"
+
+
+float FingertipDetector::getCurvature(const vector<ofPoint> & pts, int i) const{
+
+    int n = pts.size();
+    const ofPoint & p = pts[i];
+    const ofPoint & prev = pts[(i - k + n) % n];
+    const ofPoint & next = pts[(i + k) % n];
+
+    float ax = prev.x - p.x, ay = prev.y - p.y;
+    float bx = next.x - p.x, by = next.y - p.y;
+
+    // contours run clockwise (y down), so tips turn one way and the gaps between fingers the other
+    if (ax * by - ay * bx >= 0) return -2;
+
+    float lenSq = (ax * ax + ay * ay) * (bx * bx + by * by);
+    if (lenSq <= 0) return -2;
+
+    return (ax * bx + ay * by) / sqrt(lenSq);
+}
+
+int FingertipDetector::find(const Blob & blob, int blobIndex, vector<Fingertip> & tips) const{
+
+    const vector<ofPoint> & pts = blob.pts;
+    int n = pts.size();
+    if (k < 1 || n < 2 * k + 1) return 0;
+
+    float minCos = cos(ofDegToRad(maxAngle));
+
+    // start just after a point that isn't a candidate, so no run wraps around the start
+    int start = -1;
+    for (int i=0; i<n; i++){
+        if (getCurvature(pts, i) < minCos){
+            start = i;
+            break;
+        }
+    }
+    if (start < 0) return 0;
+
+    int found = 0;
+    int best = -1;
+    float bestCos = -2;
+
+    for (int step=1; step<=n; step++){
+
+        int i = (start + step) % n;
+        float c = getCurvature(pts, i);
+
+        if (c >= minCos){
+            // inside a run, keep its sharpest point
+            if (c > bestCos){
+                bestCos = c;
+                best = i;
+            }
+            continue;
+        }
+
+        if (best < 0) continue;
+
+        // end of a run
+        const ofPoint & p = pts[best];
+        const ofPoint & prev = pts[(best - k + n) % n];
+        const ofPoint & next = pts[(best + k) % n];
+
+        Fingertip tip;
+        tip.position = p;
+        tip.direction.set(p.x - (prev.x + next.x) * 0.5f, p.y - (prev.y + next.y) * 0.5f);
+        tip.direction.normalize();
+        tip.angle = ofRadToDeg(acos(ofClamp(bestCos, -1, 1)));
+        tip.contourIndex = best;
+        tip.blobIndex = blobIndex;
+        tips.push_back(tip);
+        found++;
+
+        best = -1;
+        bestCos = -2;
+    }
+
+    return found;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "ofMain.h"
+#include "BlobFinder.h"
+
+struct Fingertip {
+    ofPoint position;       // depth image coordinates
+    ofVec2f direction;      // unit vector the finger points along
+    float angle = 0;        // opening angle at the tip in degrees, smaller = sharper
+    int contourIndex = -1;  // -1 for a blob's centroid standing in for a tip it didn't have
+    int blobIndex = -1;
+
+    // filled in by the touch test once the interaction zone is defined
+    ofVec3f world;
+    int zone = 0;           // InteractionZone::Classification
+    int height = 0;         // mm above the surface, from the frame's height map
+};
+
+// Finds fingertips as k-curvature peaks along a blob's contour.
+// At each contour point p the vectors to the points k steps behind and ahead are compared;
+// where they close to less than maxAngle and the contour turns outwards, p is a candidate.
+// Each run of neighbouring candidates gives one fingertip, at its sharpest point.
+// One walk around the contour, nothing allocated.
+class FingertipDetector {
+public:
+
+    // appends the blob's fingertips to tips, returns how many were found
+    int find(const Blob & blob, int blobIndex, vector<Fingertip> & tips) const;
+
+    int k = 20;                 // contour steps, a bit more than a finger width
+    float maxAngle = 60;        // degrees
+
+private:
+
+    // cosine of the angle at contour point i, or -2 if it isn't a convex candidate
+    float getCurvature(const vector<ofPoint> & pts, int i) const;
+
+};
@@ -0,0 +1,42 @@
+#include "FrameGate.h"
+#include "DepthThreshold.h"
+
+
+bool FrameGate::isChanged(const ofShortPixels & rawDepth, const ofRectangle & roi, int noiseMm, int minChangedPixels){
+
+    int width = rawDepth.getWidth();
+    int x0 = roi.x;
+    int y0 = roi.y;
+    int x1 = roi.getRight();
+    int y1 = roi.getBottom();
+    int cols = MAX(x1 - x0 + step - 1, 0) / step;
+    int rows = MAX(y1 - y0 + step - 1, 0) / step;
+
+    samples.resize((size_t)cols * rows);
+    unsigned short * sample = samples.data();
+    for (int y=y0; y<y1; y+=step){
+        const unsigned short * row = rawDepth.getData() + (size_t)y * width;
+        for (int x=x0; x<x1; x+=step)
+            *sample++ = row[x];
+    }
+    samplesRoi = roi;
+
+    if (reference.empty() || referenceRoi != samplesRoi || reference.size() != samples.size()){
+        changed = 0;
+        return true;
+    }
+
+    // each sample stands for step x step pixels
+    changed = DepthThreshold::countChanged(samples.data(), reference.data(), samples.size(), noiseMm);
+    return changed * step * step >= (size_t)MAX(minChangedPixels, 1);
+}
+
+void FrameGate::setReference(){
+    reference.swap(samples);
+    referenceRoi = samplesRoi;
+}
+
+void FrameGate::reset(){
+    samples.clear();
+    reference.clear();
+}
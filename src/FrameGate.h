@@ -0,0 +1,34 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Tells a static scene from a changing one for a fraction of the cost of processing it.
+// Every step-th pixel of every step-th row of the processed roi is compared with the same
+// samples of the last frame that was processed (DepthThreshold::countChanged); samples within
+// the noise floor don't count, and neither do pixels without a reading, which flicker on edges.
+// The frame has changed once the samples beyond the floor cover minChangedPixels, so one
+// fingertip pressing down is enough while a few flickering edge pixels are not.
+// Comparing against the last processed frame rather than the previous one means a slow drift
+// still adds up to a change.
+class FrameGate {
+public:
+
+    // samples roi of the frame, true if the samples that moved by more than noiseMm stand for
+    // at least minChangedPixels pixels, or if there is no reference for this roi yet
+    bool isChanged(const ofShortPixels & rawDepth, const ofRectangle & roi, int noiseMm, int minChangedPixels);
+
+    // the frame last passed to isChanged() becomes the reference
+    void setReference();
+    void reset();
+
+    int step = 4;
+    size_t changed = 0;         // from the last isChanged(), samples beyond the noise floor
+
+private:
+
+    vector<unsigned short> samples;
+    vector<unsigned short> reference;
+    ofRectangle samplesRoi;
+    ofRectangle referenceRoi;
+
+};
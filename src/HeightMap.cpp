@@ -0,0 +1,42 @@
+#include "HeightMap.h"
+#include "DepthThreshold.h"
+
+
+void HeightMap::setup(const RayLUT & rays, const ofVec3f & normal, float d){
+
+    if (isAllocated() && rays.getWidth() == width && rays.getHeight() == height && normal == this->normal && d == this->d)
+        return;
+
+    this->normal = normal;
+    this->d = d;
+    width = rays.getWidth();
+    height = rays.getHeight();
+
+    coeff.resize(rays.rayX.size());
+    for (size_t i=0; i<coeff.size(); i++)
+        coeff[i] = normal.x * rays.rayX[i] + normal.y * rays.rayY[i] + normal.z;
+}
+
+bool HeightMap::update(const ofShortPixels & rawDepth, const ofRectangle & roi, vector<short> & heights) const{
+
+    heights.resize((size_t)roi.width * roi.height);
+    return updateRows(rawDepth, roi, heights.data(), 0, roi.height);
+}
+
+bool HeightMap::updateRows(const ofShortPixels & rawDepth, const ofRectangle & roi, short * heights, int begin, int end) const{
+
+    int roiX = roi.x;
+    int roiY = roi.y;
+    int roiW = roi.width;
+
+    if (!isAllocated() || rawDepth.getWidth() != width || rawDepth.getHeight() != height){
+        std::fill(heights + (size_t)begin * roiW, heights + (size_t)end * roiW, DepthThreshold::NO_HEIGHT);
+        return false;
+    }
+
+    for (int y=begin; y<end; y++){
+        size_t src = (size_t)(roiY + y) * width + roiX;
+        DepthThreshold::planeHeight(rawDepth.getData() + src, coeff.data() + src, d, heights + (size_t)y * roiW, roiW);
+    }
+    return true;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "ofMain.h"
+#include "RayLUT.h"
+
+// Signed distance of every depth pixel from the workspace surface, in mm.
+// A pixel's world point is ray * z, so its distance from the plane n.p + d = 0 is
+// z * (n . ray) + d. n . ray is kept per pixel, which makes the whole map one
+// multiply-add per pixel (DepthThreshold::planeHeight).
+class HeightMap {
+public:
+
+    // normal is unit length, pointing up out of the surface. Only rebuilds when something changed.
+    void setup(const RayLUT & rays, const ofVec3f & normal, float d);
+    bool isAllocated() const { return !coeff.empty(); }
+
+    // heights for the roi of the depth frame, roi sized and row major,
+    // DepthThreshold::NO_HEIGHT where there's no depth reading. If the map isn't set up for a
+    // frame this size every height is NO_HEIGHT, so nothing reads stale heights, and it returns false.
+    bool update(const ofShortPixels & rawDepth, const ofRectangle & roi, vector<short> & heights) const;
+
+    // just rows [begin, end) of the roi, into an already roi sized heights, so bands can be split across threads
+    bool updateRows(const ofShortPixels & rawDepth, const ofRectangle & roi, short * heights, int begin, int end) const;
+
+private:
+
+    vector<float> coeff;
+    int width = 0, height = 0;
+    ofVec3f normal;
+    float d = 0;
+
+};
@@ -0,0 +1,133 @@
+#include "InteractionZone.h"
+#include "DepthThreshold.h"
+
+
+void InteractionZone::setup(const vector<ofVec3f> & corners){
+
+    bDefined = false;
+    if (corners.size() < 8) return;
+
+    ofVec3f center;
+    for (int i=0; i<8; i++)
+        center += corners[i];
+    center /= 8;
+
+    // plane through a, b, c facing the middle of the zone
+    auto setPlane = [&](int i, const ofVec3f & a, const ofVec3f & b, const ofVec3f & c){
+        ofVec3f n = (b - a).getCrossed(c - a).getNormalized();
+        if (n.dot(center - a) < 0) n = -n;
+        nx[i] = n.x;
+        ny[i] = n.y;
+        nz[i] = n.z;
+        d[i] = -n.dot(a);
+    };
+
+    // the surface and top take the normal of the whole quad (Newell), the corners
+    // of a measured workspace are rarely exactly coplanar
+    auto setQuadPlane = [&](int i, int first){
+        ofVec3f n, mid;
+        for (int k=0; k<4; k++){
+            const ofVec3f & p = corners[first + k];
+            const ofVec3f & q = corners[first + (k + 1) % 4];
+            n.x += (p.y - q.y) * (p.z + q.z);
+            n.y += (p.z - q.z) * (p.x + q.x);
+            n.z += (p.x - q.x) * (p.y + q.y);
+            mid += p;
+        }
+        mid /= 4;
+        n.normalize();
+        if (n.dot(center - mid) < 0) n = -n;
+        nx[i] = n.x;
+        ny[i] = n.y;
+        nz[i] = n.z;
+        d[i] = -n.dot(mid);
+    };
+
+    setQuadPlane(0, 0);
+    setQuadPlane(1, 4);
+    for (int k=0; k<4; k++)
+        setPlane(2 + k, corners[k], corners[(k + 1) % 4], corners[4 + k]);
+
+    bDefined = true;
+}
+
+void InteractionZone::clear(){
+    bDefined = false;
+}
+
+float InteractionZone::getHeight(const ofVec3f & pt) const{
+    return nx[0] * pt.x + ny[0] * pt.y + nz[0] * pt.z + d[0];
+}
+
+void InteractionZone::getSurfacePlane(ofVec3f & normal, float & d) const{
+    normal.set(nx[0], ny[0], nz[0]);
+    d = this->d[0];
+}
+
+InteractionZone::Classification InteractionZone::classify(const ofVec3f & pt) const{
+    unsigned char c;
+    classify(&pt.x, &pt.y, &pt.z, 1, &c);
+    return (Classification)c;
+}
+
+void InteractionZone::classify(const float * x, const float * y, const float * z, size_t n, unsigned char * out) const{
+
+    if (!bDefined){
+        memset(out, OUTSIDE, n);
+        return;
+    }
+
+    // copy the planes to locals so the loop body is pure arithmetic and vectorises
+    const float n0x = nx[0], n0y = ny[0], n0z = nz[0], d0 = d[0];
+    const float n1x = nx[1], n1y = ny[1], n1z = nz[1], d1 = d[1];
+    const float n2x = nx[2], n2y = ny[2], n2z = nz[2], d2 = d[2];
+    const float n3x = nx[3], n3y = ny[3], n3z = nz[3], d3 = d[3];
+    const float n4x = nx[4], n4y = ny[4], n4z = nz[4], d4 = d[4];
+    const float n5x = nx[5], n5y = ny[5], n5z = nz[5], d5 = d[5];
+    const float touch = touchHeight;
+
+    for (size_t i=0; i<n; i++){
+
+        float px = x[i], py = y[i], pz = z[i];
+
+        float height = n0x * px + n0y * py + n0z * pz + d0;
+        float side = n1x * px + n1y * py + n1z * pz + d1;
+        side = MIN(side, n2x * px + n2y * py + n2z * pz + d2);
+        side = MIN(side, n3x * px + n3y * py + n3z * pz + d3);
+        side = MIN(side, n4x * px + n4y * py + n4z * pz + d4);
+        side = MIN(side, n5x * px + n5y * py + n5z * pz + d5);
+
+        bool inside = side >= 0 && height >= -touch && pz > 0;
+        out[i] = inside ? (height <= touch ? TOUCH : HOVER) : OUTSIDE;
+    }
+}
+
+void InteractionZone::classify(const float * x, const float * y, const float * z, const short * height, size_t n, unsigned char * out) const{
+
+    if (!bDefined){
+        memset(out, OUTSIDE, n);
+        return;
+    }
+
+    const float n1x = nx[1], n1y = ny[1], n1z = nz[1], d1 = d[1];
+    const float n2x = nx[2], n2y = ny[2], n2z = nz[2], d2 = d[2];
+    const float n3x = nx[3], n3y = ny[3], n3z = nz[3], d3 = d[3];
+    const float n4x = nx[4], n4y = ny[4], n4z = nz[4], d4 = d[4];
+    const float n5x = nx[5], n5y = ny[5], n5z = nz[5], d5 = d[5];
+    const float touch = touchHeight;
+
+    for (size_t i=0; i<n; i++){
+
+        float px = x[i], py = y[i], pz = z[i];
+        int h = height[i];
+
+        float side = n1x * px + n1y * py + n1z * pz + d1;
+        side = MIN(side, n2x * px + n2y * py + n2z * pz + d2);
+        side = MIN(side, n3x * px + n3y * py + n3z * pz + d3);
+        side = MIN(side, n4x * px + n4y * py + n4z * pz + d4);
+        side = MIN(side, n5x * px + n5y * py + n5z * pz + d5);
+
+        bool inside = side >= 0 && h != DepthThreshold::NO_HEIGHT && h >= -touch;
+        out[i] = inside ? (h <= touch ? TOUCH : HOVER) : OUTSIDE;
+    }
+}
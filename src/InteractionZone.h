@@ -0,0 +1,48 @@
+#pragma once
+
+#include "ofMain.h"
+
+// The interaction zone prism as six inward facing planes, for deciding touch by real height.
+// Built from the zone mesh's eight corners (0-3 on the surface, 4-7 above them) whenever
+// the zone changes, so classifying a point is a handful of dot products.
+class InteractionZone {
+public:
+
+    enum Classification {
+        OUTSIDE = 0,
+        HOVER,          // inside the zone, above the touch height
+        TOUCH           // within touchHeight of the surface
+    };
+
+    // corners in world coordinates (mm): 0-3 around the surface, 4-7 the matching top corners
+    void setup(const vector<ofVec3f> & corners);
+    void clear();
+    bool isDefined() const { return bDefined; }
+
+    // signed distance from the surface, positive towards the top of the zone
+    float getHeight(const ofVec3f & pt) const;
+
+    // the surface as n.p + d = 0, n unit length and pointing into the zone
+    void getSurfacePlane(ofVec3f & normal, float & d) const;
+
+    Classification classify(const ofVec3f & pt) const;
+
+    // classifies n points given as separate x, y, z arrays, one Classification per point in out
+    void classify(const float * x, const float * y, const float * z, size_t n, unsigned char * out) const;
+
+    // as above, with each point's height above the surface already known (mm, from a HeightMap,
+    // DepthThreshold::NO_HEIGHT for no reading), so the planes only decide the sides and top
+    void classify(const float * x, const float * y, const float * z, const short * height, size_t n, unsigned char * out) const;
+
+    // within this distance (mm) of the surface counts as touching, on either side of it
+    // since depth noise puts some fingertip readings just below the surface
+    float touchHeight = 15;
+
+private:
+
+    // plane i: nx[i] * x + ny[i] * y + nz[i] * z + d[i] >= 0 inside, normals unit length.
+    // 0 is the surface, 1 the top, 2-5 the sides
+    float nx[6], ny[6], nz[6], d[6];
+    bool bDefined = false;
+
+};
@@ -0,0 +1,87 @@
+#include "KinectDepthSource.h"
+
+
+bool KinectDepthSource::open(){
+
+	// enable depth->video image calibration
+	kinect.setRegistration(true);
+
+	// no textures: frames are read on the processing thread and drawn by the app
+	kinect.init(false, true, false);
+	//kinect.init(true); // shows infrared instead of RGB video image
+	//kinect.init(false, false); // disable video image (faster fps)
+
+	kinect.open();		// opens first available kinect
+	//kinect.open(1);	// open a kinect by id, starting with 0 (sorted by serial # lexicographically))
+	//kinect.open("A00362A08602047A");	// open a kinect using it's unique serial #
+
+	// print the intrinsic IR sensor values
+	if(kinect.isConnected()) {
+		ofLogNotice() << "sensor-emitter dist: " << kinect.getSensorEmitterDistance() << "cm";
+		ofLogNotice() << "sensor-camera dist:  " << kinect.getSensorCameraDistance() << "cm";
+		ofLogNotice() << "zero plane pixel size: " << kinect.getZeroPlanePixelSize() << "mm";
+		ofLogNotice() << "zero plane dist: " << kinect.getZeroPlaneDistance() << "mm";
+	}
+
+    return kinect.isConnected();
+}
+
+void KinectDepthSource::close(){
+	kinect.setCameraTiltAngle(0); // zero the tilt on exit
+	kinect.close();
+}
+
+void KinectDepthSource::update(){
+    kinect.update();
+
+    if (kinect.isFrameNew())
+        frameTimestamp = ofGetElapsedTimeMicros();
+}
+
+bool KinectDepthSource::isConnected(){
+    return kinect.isConnected();
+}
+
+bool KinectDepthSource::isFrameNew(){
+    return kinect.isFrameNew();
+}
+
+int KinectDepthSource::getWidth(){
+    return kinect.width;
+}
+
+int KinectDepthSource::getHeight(){
+    return kinect.height;
+}
+
+ofPixels & KinectDepthSource::getDepthPixels(){
+    return kinect.getDepthPixels();
+}
+
+ofShortPixels & KinectDepthSource::getRawDepthPixels(){
+    return kinect.getRawDepthPixels();
+}
+
+ofPixels & KinectDepthSource::getPixels(){
+    return kinect.getPixels();
+}
+
+uint64_t KinectDepthSource::getFrameTimestamp(){
+    return frameTimestamp;
+}
+
+float KinectDepthSource::getZeroPlanePixelSize(){
+    return kinect.getZeroPlanePixelSize();
+}
+
+float KinectDepthSource::getZeroPlaneDistance(){
+    return kinect.getZeroPlaneDistance();
+}
+
+ofVec3f KinectDepthSource::getWorldCoordinateAt(int x, int y){
+    return kinect.getWorldCoordinateAt(x, y);
+}
+
+ofVec3f KinectDepthSource::getWorldCoordinateAt(float cx, float cy, float wz){
+    return kinect.getWorldCoordinateAt(cx, cy, wz);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "ofxKinect.h"
+#include "DepthSource.h"
+
+// Live depth frames from a Kinect through ofxKinect.
+// The kinect is public so the app can still drive the tilt motor, LED and accelerometer.
+class KinectDepthSource : public DepthSource {
+public:
+
+    bool open();
+    void close();
+    void update();
+
+    bool isConnected();
+    bool isFrameNew();
+
+    int getWidth();
+    int getHeight();
+
+    ofPixels & getDepthPixels();
+    ofShortPixels & getRawDepthPixels();
+    ofPixels & getPixels();
+
+    uint64_t getFrameTimestamp();
+
+    float getZeroPlanePixelSize();
+    float getZeroPlaneDistance();
+
+    ofVec3f getWorldCoordinateAt(int x, int y);
+    ofVec3f getWorldCoordinateAt(float cx, float cy, float wz);
+
+    ofxKinect kinect;
+
+    // ofxKinect doesn't expose the libfreenect timestamp, so frames are stamped on arrival
+    uint64_t frameTimestamp = 0;
+
+};
@@ -0,0 +1,65 @@
+#include "LatencyHistogram.h"
+
+
+LatencyHistogram::LatencyHistogram(){
+    reset();
+}
+
+int LatencyHistogram::getBucket(uint64_t micros){
+
+    if (micros < SUB_BUCKETS) return micros;
+
+    // the top five bits pick the bucket: the leading one gives the power of two, the
+    // four below it the sub bucket
+    int msb = 63 - __builtin_clzll(micros);
+    int shift = msb - 4;
+    int bucket = SUB_BUCKETS + shift * SUB_BUCKETS + (int)((micros >> shift) & (SUB_BUCKETS - 1));
+    return MIN(bucket, NUM_BUCKETS - 1);
+}
+
+uint32_t LatencyHistogram::getBucketValue(int bucket){
+
+    if (bucket < SUB_BUCKETS) return bucket;
+
+    int shift = (bucket - SUB_BUCKETS) / SUB_BUCKETS;
+    int sub = (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+    uint64_t low = (uint64_t)(SUB_BUCKETS + sub) << shift;
+    return MIN(low + ((uint64_t)1 << shift) - 1, (uint64_t)UINT32_MAX);
+}
+
+void LatencyHistogram::record(uint64_t micros){
+    counts[getBucket(micros)]++;
+    count++;
+    max = MAX(max, (uint32_t)MIN(micros, (uint64_t)UINT32_MAX));
+}
+
+void LatencyHistogram::reset(){
+    memset(counts, 0, sizeof(counts));
+    count = 0;
+    max = 0;
+}
+
+uint32_t LatencyHistogram::getPercentile(float percentile) const{
+
+    if (count == 0) return 0;
+
+    uint64_t target = ceil(count * (double)percentile / 100.0);
+    target = ofClamp(target, 1, count);
+
+    uint64_t seen = 0;
+    for (int i=0; i<NUM_BUCKETS; i++){
+        seen += counts[i];
+        if (seen >= target) return MIN(getBucketValue(i), max);
+    }
+    return max;
+}
+
+LatencyPercentiles LatencyHistogram::getPercentiles() const{
+    LatencyPercentiles p;
+    p.p50 = getPercentile(50);
+    p.p95 = getPercentile(95);
+    p.p99 = getPercentile(99);
+    p.max = max;
+    p.count = count;
+    return p;
+}
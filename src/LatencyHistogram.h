@@ -0,0 +1,39 @@
+#pragma once
+
+#include "ofMain.h"
+
+struct LatencyPercentiles {
+    uint32_t p50 = 0, p95 = 0, p99 = 0, max = 0;   // microseconds
+    uint32_t count = 0;
+};
+
+// Durations in microseconds counted into log-linear buckets, HdrHistogram style: values
+// below 16 are exact, above that every power of two is split into 16 buckets, so a
+// percentile is within about 6% of the true value. Fixed size, recording never allocates.
+class LatencyHistogram {
+public:
+
+    LatencyHistogram();
+
+    void record(uint64_t micros);
+    void reset();
+
+    uint32_t getCount() const { return count; }
+
+    // highest value in the bucket holding the given percentile (0-100)
+    uint32_t getPercentile(float percentile) const;
+    LatencyPercentiles getPercentiles() const;
+
+    static const int SUB_BUCKETS = 16;
+    static const int NUM_BUCKETS = SUB_BUCKETS + 28 * SUB_BUCKETS;     // up to 2^32 us
+
+private:
+
+    static int getBucket(uint64_t micros);
+    static uint32_t getBucketValue(int bucket);
+
+    uint32_t counts[NUM_BUCKETS];
+    uint32_t count = 0;
+    uint32_t max = 0;
+
+};
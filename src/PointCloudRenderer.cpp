@@ -0,0 +1,89 @@
+#include "PointCloudRenderer.h"
+
+
+void PointCloudRenderer::setup(int width, int height, int step, WorkerPool * workers){
+
+    this->width = width;
+    this->height = height;
+    this->step = MAX(1, step);
+    this->workers = workers;
+
+    cols = (width + this->step - 1) / this->step;
+    rows = (height + this->step - 1) / this->step;
+
+    vertices.assign(cols * rows, ofVec3f());
+    colors.assign(cols * rows, ofFloatColor::white);
+    rowStart.assign(rows + 1, 0);
+    numPoints = 0;
+
+    vbo.setVertexData(vertices.data(), vertices.size(), GL_DYNAMIC_DRAW);
+    vbo.setColorData(colors.data(), colors.size(), GL_DYNAMIC_DRAW);
+}
+
+void PointCloudRenderer::update(const ofShortPixels & rawDepth, const ofPixels & color, const RayLUT & rays, float minZ, float maxZ){
+
+    if (!rawDepth.isAllocated() || rawDepth.getWidth() != width || rawDepth.getHeight() != height || !rays.isAllocated())
+        return;
+
+    const unsigned short * depth = rawDepth.getData();
+    const float * rayX = rays.rayX.data();
+    const float * rayY = rays.rayY.data();
+
+    // the kept points are packed to the front, so count each row first to know where its points go
+    auto countRows = [&](size_t begin, size_t end){
+        for (size_t r=begin; r<end; r++){
+            const unsigned short * row = depth + r * step * width;
+            int n = 0;
+            for (int x=0; x<width; x+=step)
+                n += row[x] > 0 && row[x] > minZ && row[x] < maxZ;
+            rowStart[r + 1] = n;
+        }
+    };
+
+    bColor = color.isAllocated() && color.getWidth() == width && color.getHeight() == height;
+    const unsigned char * rgb = bColor ? color.getData() : NULL;
+
+    auto fillRows = [&](size_t begin, size_t end){
+        for (size_t r=begin; r<end; r++){
+            size_t y = r * step;
+            int out = rowStart[r];
+            for (int x=0; x<width; x+=step){
+                size_t i = y * width + x;
+                float z = depth[i];
+                if (z <= 0 || z <= minZ || z >= maxZ) continue;
+                vertices[out].set(rayX[i] * z, rayY[i] * z, z);
+                if (rgb)
+                    colors[out].set(rgb[i * 3] / 255.f, rgb[i * 3 + 1] / 255.f, rgb[i * 3 + 2] / 255.f);
+                out++;
+            }
+        }
+    };
+
+    if (workers) workers->parallelFor(rows, countRows, 8);
+    else countRows(0, rows);
+
+    rowStart[0] = 0;
+    for (int r=0; r<rows; r++)
+        rowStart[r + 1] += rowStart[r];
+    numPoints = rowStart[rows];
+
+    if (workers) workers->parallelFor(rows, fillRows, 8);
+    else fillRows(0, rows);
+
+    // only upload what's in use
+    if (numPoints > 0){
+        vbo.updateVertexData(vertices.data(), numPoints);
+        if (bColor)
+            vbo.updateColorData(colors.data(), numPoints);
+    }
+}
+
+void PointCloudRenderer::draw(){
+
+    if (numPoints == 0) return;
+
+    if (bColor) vbo.enableColors();
+    else vbo.disableColors();
+
+    vbo.draw(GL_POINTS, 0, numPoints);
+}
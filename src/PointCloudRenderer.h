@@ -0,0 +1,38 @@
+#pragma once
+
+#include "ofMain.h"
+#include "RayLUT.h"
+#include "WorkerPool.h"
+
+// Keeps the point cloud in a vbo sized for the whole sensor, allocated once.
+// update() converts the depth frame through the ray table a row at a time across the worker
+// pool, packs the kept points to the front of the buffers and uploads only that range.
+class PointCloudRenderer {
+public:
+
+    // every step-th pixel in x and y becomes a point
+    void setup(int width, int height, int step, WorkerPool * workers);
+
+    // keeps points with minZ < z < maxZ (mm), colour is optional
+    void update(const ofShortPixels & rawDepth, const ofPixels & color, const RayLUT & rays, float minZ, float maxZ);
+    void draw();
+
+    int getNumPoints() const { return numPoints; }
+
+private:
+
+    WorkerPool * workers = NULL;
+
+    int width = 0, height = 0;
+    int step = 1;
+    int cols = 0, rows = 0;         // sampled grid
+
+    vector<ofVec3f> vertices;
+    vector<ofFloatColor> colors;
+    vector<int> rowStart;           // where each sampled row's points go, plus the total
+    int numPoints = 0;
+    bool bColor = false;
+
+    ofVbo vbo;
+
+};
@@ -0,0 +1,95 @@
+#include "ProjectorLUT.h"
+
+
+void ProjectorLUT::setup(const RayLUT & rays, const ofVec3f & normal, float d, const CalibrationFileHeader & model){
+
+    width = rays.getWidth();
+    height = rays.getHeight();
+    entries.resize((size_t)width * height);
+
+    // rotation matrix from the Rodrigues vector
+    double r[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+    double theta = sqrt(model.rotation[0] * model.rotation[0] + model.rotation[1] * model.rotation[1] + model.rotation[2] * model.rotation[2]);
+    if (theta > 1e-12){
+        double kx = model.rotation[0] / theta, ky = model.rotation[1] / theta, kz = model.rotation[2] / theta;
+        double c = cos(theta), s = sin(theta), t = 1 - c;
+        r[0] = c + kx * kx * t;         r[1] = kx * ky * t - kz * s;    r[2] = kx * kz * t + ky * s;
+        r[3] = ky * kx * t + kz * s;    r[4] = c + ky * ky * t;         r[5] = ky * kz * t - kx * s;
+        r[6] = kz * kx * t - ky * s;    r[7] = kz * ky * t + kx * s;    r[8] = c + kz * kz * t;
+    }
+
+    const double * t = model.translation;
+    double fx = model.camera[0], cx = model.camera[2];
+    double fy = model.camera[4], cy = model.camera[5];
+    double k1 = model.distortion[0], k2 = model.distortion[1];
+    double p1 = model.distortion[2], p2 = model.distortion[3], k3 = model.distortion[4];
+
+    // anything this far off the projector can't be represented in 12.4 anyway
+    const double limit = 32767.0 / (1 << FRACTION_BITS);
+    int valid = 0;
+
+    for (size_t i=0; i<entries.size(); i++){
+
+        Entry & e = entries[i];
+        e.x = e.y = INVALID;
+
+        // ray * z on the plane: z = -d / (n . ray)
+        double rx = rays.rayX[i], ry = rays.rayY[i];
+        double denom = normal.x * rx + normal.y * ry + normal.z;
+        if (fabs(denom) < 1e-9) continue;
+        double z = -d / denom;
+        if (z <= 0) continue;
+
+        double wx = rx * z, wy = ry * z, wz = z;
+
+        // into the projector's frame
+        double px = r[0] * wx + r[1] * wy + r[2] * wz + t[0];
+        double py = r[3] * wx + r[4] * wy + r[5] * wz + t[1];
+        double pz = r[6] * wx + r[7] * wy + r[8] * wz + t[2];
+        if (pz <= 0) continue;
+
+        double x = px / pz, y = py / pz;
+        double r2 = x * x + y * y;
+        double radial = 1 + r2 * (k1 + r2 * (k2 + r2 * k3));
+        double xd = x * radial + 2 * p1 * x * y + p2 * (r2 + 2 * x * x);
+        double yd = y * radial + p1 * (r2 + 2 * y * y) + 2 * p2 * x * y;
+
+        double u = fx * xd + cx;
+        double v = fy * yd + cy;
+        if (u < 0 || v < 0 || u >= model.width || v >= model.height || u >= limit || v >= limit) continue;
+
+        e.x = (int16_t)lround(u * (1 << FRACTION_BITS));
+        e.y = (int16_t)lround(v * (1 << FRACTION_BITS));
+        valid++;
+    }
+
+    ofLogNotice("ProjectorLUT") << valid << " of " << entries.size() << " depth pixels land on the projector";
+}
+
+void ProjectorLUT::clear(){
+    entries.clear();
+    width = height = 0;
+}
+
+void ProjectorLUT::map(const ofPoint * depthPoints, size_t n, ofVec2f * projected, unsigned char * valid) const{
+    for (size_t i=0; i<n; i++)
+        valid[i] = map(lround(depthPoints[i].x), lround(depthPoints[i].y), projected[i]);
+}
+
+bool ProjectorLUT::mapVelocity(int x, int y, const ofVec2f & velocity, ofVec2f & projected) const{
+
+    ofVec2f center, next;
+    if (!map(x, y, center)) return false;
+
+    // one pixel step along each axis, backwards at the edge of the projector
+    ofVec2f dx, dy;
+    if (map(x + 1, y, next)) dx = next - center;
+    else if (map(x - 1, y, next)) dx = center - next;
+    else return false;
+    if (map(x, y + 1, next)) dy = next - center;
+    else if (map(x, y - 1, next)) dy = center - next;
+    else return false;
+
+    projected = dx * velocity.x + dy * velocity.y;
+    return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "ofMain.h"
+#include "RayLUT.h"
+#include "CalibrationFile.h"
+
+// Where each depth pixel lands in the projector image, assuming it lies on the workspace surface.
+// Every pixel's ray is intersected with the surface plane and pushed through the solved projector
+// model (the same pinhole + distortion model cv::projectPoints uses), once, when the calibration
+// or the surface changes. Entries are 12.4 fixed point packed into 32 bits, so mapping a touch
+// is a single load.
+class ProjectorLUT {
+public:
+
+    struct Entry {
+        int16_t x, y;       // projector pixel * 16, x == INVALID where the pixel misses the projector
+    };
+
+    static const int16_t INVALID = -32768;
+    static const int FRACTION_BITS = 4;
+
+    // surface plane n.p + d = 0 in depth camera world coordinates, model from a solved calibration
+    void setup(const RayLUT & rays, const ofVec3f & normal, float d, const CalibrationFileHeader & model);
+    void clear();
+    bool isAllocated() const { return !entries.empty(); }
+
+    // projector position of depth pixel (x, y), false if it doesn't map onto the projector
+    inline bool map(int x, int y, ofVec2f & projected) const{
+        if (x < 0 || y < 0 || x >= width || y >= height) return false;
+        Entry e = entries[(size_t)y * width + x];
+        if (e.x == INVALID) return false;
+        projected.set(e.x * (1.f / (1 << FRACTION_BITS)), e.y * (1.f / (1 << FRACTION_BITS)));
+        return true;
+    }
+
+    // a velocity at depth pixel (x, y) in projector pixels, through the lut's local slope there;
+    // false if the pixel or both of its neighbours along an axis miss the projector
+    bool mapVelocity(int x, int y, const ofVec2f & velocity, ofVec2f & projected) const;
+
+    // maps n depth image points, valid[i] = 0 where a point doesn't land on the projector
+    void map(const ofPoint * depthPoints, size_t n, ofVec2f * projected, unsigned char * valid) const;
+
+    vector<Entry> entries;
+
+private:
+
+    int width = 0, height = 0;
+
+};
@@ -0,0 +1,50 @@
+#include "RayLUT.h"
+
+
+void RayLUT::setupKinect(int width, int height, float zeroPlanePixelSize, float zeroPlaneDistance){
+
+    // factor = 2 * ref_pix_size * z / ref_distance, per freenect
+    float scale = 2 * zeroPlanePixelSize / zeroPlaneDistance;
+    setupPinhole(width, height, 1 / scale, 1 / scale, width / 2, height / 2);
+}
+
+void RayLUT::setupPinhole(int width, int height, float fx, float fy, float cx, float cy){
+
+    this->width = width;
+    this->height = height;
+
+    rayX.resize((size_t)width * height);
+    rayY.resize((size_t)width * height);
+
+    size_t i = 0;
+    for (int y=0; y<height; y++){
+        for (int x=0; x<width; x++, i++){
+            rayX[i] = (x - cx) / fx;
+            rayY[i] = (y - cy) / fy;
+        }
+    }
+}
+
+ofVec3f RayLUT::getWorldCoordinateAt(int x, int y, float z) const{
+
+    if (x < 0 || y < 0 || x >= width || y >= height)
+        return ofVec3f();
+
+    size_t i = (size_t)y * width + x;
+    return ofVec3f(rayX[i] * z, rayY[i] * z, z);
+}
+
+void RayLUT::toWorld(const unsigned short * depth, size_t start, size_t numPixels, float * __restrict x, float * __restrict y, float * __restrict z) const{
+
+    const float * __restrict rx = rayX.data() + start;
+    const float * __restrict ry = rayY.data() + start;
+    depth += start;
+
+    // straight line code over flat arrays, so the compiler vectorises it
+    for (size_t i=0; i<numPixels; i++){
+        float d = depth[i];
+        x[i] = rx[i] * d;
+        y[i] = ry[i] * d;
+        z[i] = d;
+    }
+}
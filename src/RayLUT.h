@@ -0,0 +1,36 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Per-pixel viewing rays of the depth camera, scaled so z = 1.
+// Built once from the intrinsics, after which a depth pixel's world position is just
+// (rayX * z, rayY * z, z), so a whole frame converts with one multiply per coordinate.
+class RayLUT {
+public:
+
+    // libfreenect's zero plane model, matching freenect_camera_to_world()
+    void setupKinect(int width, int height, float zeroPlanePixelSize, float zeroPlaneDistance);
+
+    // pinhole camera: focal lengths and principal point in pixels, e.g. read from the
+    // 3x3 camera matrix CalibrateCoords solves for (fx = m(0,0), fy = m(1,1), cx = m(0,2), cy = m(1,2))
+    void setupPinhole(int width, int height, float fx, float fy, float cx, float cy);
+
+    bool isAllocated() const { return !rayX.empty(); }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    ofVec3f getWorldCoordinateAt(int x, int y, float z) const;
+
+    // converts numPixels depth values starting at pixel index start (row major) to world
+    // coordinates, written to the caller's x, y and z arrays. No reading (0) gives (0, 0, 0).
+    void toWorld(const unsigned short * depth, size_t start, size_t numPixels, float * x, float * y, float * z) const;
+
+    vector<float> rayX;
+    vector<float> rayY;
+
+private:
+
+    int width = 0;
+    int height = 0;
+
+};
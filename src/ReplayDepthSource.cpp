@@ -0,0 +1,229 @@
+#include "ReplayDepthSource.h"
+
+#ifndef TARGET_WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+ReplayDepthSource::~ReplayDepthSource(){
+    close();
+}
+
+bool ReplayDepthSource::load(string filePath){
+    path = ofToDataPath(filePath);
+    return open();
+}
+
+bool ReplayDepthSource::open(){
+
+    close();
+
+#ifdef TARGET_WIN32
+    buffer = ofBufferFromFile(path, true);
+    data = (unsigned char *)buffer.getData();
+    dataSize = buffer.size();
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0){
+        ofLogError("ReplayDepthSource") << "could not open " << path;
+        return false;
+    }
+
+    struct stat info;
+    fstat(fd, &info);
+    dataSize = info.st_size;
+
+    // private + writable so the pixels can wrap the mapping directly; nothing is ever written back
+    void * mapped = mmap(NULL, dataSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (mapped == MAP_FAILED){
+        ofLogError("ReplayDepthSource") << "could not map " << path;
+        dataSize = 0;
+        return false;
+    }
+    data = (unsigned char *)mapped;
+#endif
+
+    if (dataSize < sizeof(DepthRecordingHeader)){
+        ofLogError("ReplayDepthSource") << path << " is too small to be a recording";
+        close();
+        return false;
+    }
+
+    memcpy(&header, data, sizeof(header));
+
+    if (memcmp(header.magic, "K2TD", 4) != 0 || header.version != DEPTH_RECORDING_VERSION){
+        ofLogError("ReplayDepthSource") << path << " is not a version " << DEPTH_RECORDING_VERSION << " recording";
+        close();
+        return false;
+    }
+
+    frameSize = depthRecordingFrameSize(header);
+
+    // trust the file length over the header in case the recording wasn't closed cleanly
+    size_t framesOnDisk = (dataSize - sizeof(header)) / frameSize;
+    if (framesOnDisk < header.frameCount || header.frameCount == 0)
+        header.frameCount = framesOnDisk;
+
+    if (header.frameCount == 0){
+        ofLogError("ReplayDepthSource") << path << " has no frames";
+        close();
+        return false;
+    }
+
+    depthPixels.allocate(header.width, header.height, OF_PIXELS_GRAY);
+
+    depthLookupTable.resize(10000);
+    depthLookupTable[0] = 0;
+    for (int i=1; i<depthLookupTable.size(); i++)
+        depthLookupTable[i] = ofMap(i, nearClipping, farClipping, 255, 0, true);
+
+    ofLogNotice("ReplayDepthSource") << "loaded " << header.frameCount << " frames ("
+        << header.width << "x" << header.height << ") from " << path;
+
+    frameIndex = -1;
+    bFrameNew = false;
+
+    return true;
+}
+
+void ReplayDepthSource::close(){
+
+    if (data == NULL) return;
+
+#ifdef TARGET_WIN32
+    buffer.clear();
+#else
+    munmap(data, dataSize);
+#endif
+
+    data = NULL;
+    dataSize = 0;
+    frameIndex = -1;
+    bFrameNew = false;
+}
+
+void ReplayDepthSource::update(){
+
+    bFrameNew = false;
+
+    if (!isConnected()) return;
+
+    int count = getFrameCount();
+    int next = frameIndex + 1;
+
+    if (bRealtime && frameIndex >= 0){
+
+        uint64_t target = firstTimestamp + (ofGetElapsedTimeMicros() - playbackStart);
+
+        // not due yet
+        if (next < count && getTimestampAt(next) > target) return;
+
+        // skip frames we've fallen behind on, like a live sensor would
+        while (next + 1 < count && getTimestampAt(next + 1) <= target) next++;
+    }
+
+    if (next >= count){
+        if (!bLoop) return;
+        next = 0;
+    }
+
+    setFrame(next);
+}
+
+void ReplayDepthSource::setFrame(int frame){
+
+    if (!isConnected()) return;
+
+    frameIndex = ofClamp(frame, 0, getFrameCount() - 1);
+
+    if (frameIndex == 0){
+        playbackStart = ofGetElapsedTimeMicros();
+        firstTimestamp = getTimestampAt(0);
+    }
+
+    unsigned char * record = data + sizeof(header) + frameIndex * frameSize;
+    unsigned short * raw = (unsigned short *)(record + sizeof(uint64_t));
+    size_t numPixels = (size_t)header.width * header.height;
+
+    rawDepthPixels.setFromExternalPixels(raw, header.width, header.height, OF_PIXELS_GRAY);
+
+    if (header.hasColor)
+        colorPixels.setFromExternalPixels((unsigned char *)(raw + numPixels), header.width, header.height, OF_PIXELS_RGB);
+
+    unsigned char * depth = depthPixels.getData();
+    const int maxDepth = depthLookupTable.size() - 1;
+    for (size_t i=0; i<numPixels; i++)
+        depth[i] = depthLookupTable[MIN(raw[i], maxDepth)];
+
+    bFrameNew = true;
+}
+
+bool ReplayDepthSource::isConnected(){
+    return data != NULL;
+}
+
+bool ReplayDepthSource::isFrameNew(){
+    return bFrameNew;
+}
+
+int ReplayDepthSource::getWidth(){
+    return header.width;
+}
+
+int ReplayDepthSource::getHeight(){
+    return header.height;
+}
+
+ofPixels & ReplayDepthSource::getDepthPixels(){
+    return depthPixels;
+}
+
+ofShortPixels & ReplayDepthSource::getRawDepthPixels(){
+    return rawDepthPixels;
+}
+
+ofPixels & ReplayDepthSource::getPixels(){
+    return colorPixels;
+}
+
+uint64_t ReplayDepthSource::getFrameTimestamp(){
+    return frameIndex < 0 ? 0 : getTimestampAt(frameIndex);
+}
+
+float ReplayDepthSource::getZeroPlanePixelSize(){
+    return header.zeroPlanePixelSize;
+}
+
+float ReplayDepthSource::getZeroPlaneDistance(){
+    return header.zeroPlaneDistance;
+}
+
+ofVec3f ReplayDepthSource::getWorldCoordinateAt(int x, int y){
+    if (frameIndex < 0) return ofVec3f();
+    return getWorldCoordinateAt(x, y, rawDepthPixels[y * header.width + x]);
+}
+
+// same projection as freenect_camera_to_world()
+ofVec3f ReplayDepthSource::getWorldCoordinateAt(float cx, float cy, float wz){
+    double factor = 2 * header.zeroPlanePixelSize * wz / header.zeroPlaneDistance;
+    return ofVec3f((cx - header.width / 2) * factor, (cy - header.height / 2) * factor, wz);
+}
+
+int ReplayDepthSource::getFrameCount(){
+    return isConnected() ? header.frameCount : 0;
+}
+
+int ReplayDepthSource::getCurrentFrame(){
+    return frameIndex;
+}
+
+uint64_t ReplayDepthSource::getTimestampAt(int frame){
+    uint64_t timestamp;
+    memcpy(&timestamp, data + sizeof(header) + frame * frameSize, sizeof(timestamp));
+    return timestamp;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "DepthSource.h"
+#include "DepthRecorder.h"
+
+// Plays back a session recorded with DepthRecorder.
+// The file is memory-mapped and frames are handed out without copying the raw depth or RGB data.
+// In realtime mode frames are released at their original timestamps (dropping frames if we fall
+// behind, like a live sensor); otherwise every update() advances one frame, as fast as the caller runs.
+class ReplayDepthSource : public DepthSource {
+public:
+
+    ~ReplayDepthSource();
+
+    bool load(string filePath);
+
+    bool open();
+    void close();
+    void update();
+
+    bool isConnected();
+    bool isFrameNew();
+
+    int getWidth();
+    int getHeight();
+
+    ofPixels & getDepthPixels();
+    ofShortPixels & getRawDepthPixels();
+    ofPixels & getPixels();
+
+    uint64_t getFrameTimestamp();
+
+    float getZeroPlanePixelSize();
+    float getZeroPlaneDistance();
+
+    ofVec3f getWorldCoordinateAt(int x, int y);
+    ofVec3f getWorldCoordinateAt(float cx, float cy, float wz);
+
+    int getFrameCount();
+    int getCurrentFrame();
+    uint64_t getTimestampAt(int frame);
+    void setFrame(int frame);
+
+    bool bRealtime = true;
+    bool bLoop = true;
+
+    string path;
+    DepthRecordingHeader header = DepthRecordingHeader();
+    size_t frameSize = 0;
+
+    unsigned char * data = NULL;
+    size_t dataSize = 0;
+#ifdef TARGET_WIN32
+    ofBuffer buffer;
+#endif
+
+    int frameIndex = -1;
+    bool bFrameNew = false;
+    uint64_t playbackStart = 0;
+    uint64_t firstTimestamp = 0;
+
+    ofShortPixels rawDepthPixels;
+    ofPixels depthPixels;
+    ofPixels colorPixels;
+
+    // same raw mm -> 8-bit mapping as ofxKinect (near clip 500mm = white, far clip 4000mm = black)
+    vector<unsigned char> depthLookupTable;
+    float nearClipping = 500;
+    float farClipping = 4000;
+
+};
@@ -0,0 +1,158 @@
+#pragma once
+
+// Layout of the shared-memory touch ring, plus the reader consumer apps include.
+// Header only and free of openFrameworks, so any process on the machine can poll the
+// latest touches straight out of the mapping: no socket, no kernel transition per read.
+//
+//   SharedTouchRegion
+//     header: magic "K2TS", version, slot count, index of the newest frame
+//     SHARED_TOUCH_SLOTS x SharedTouchSlot, frame n lives in slot n % SHARED_TOUCH_SLOTS
+//
+// Each slot is a seqlock: the writer makes its sequence odd, writes the frame, then makes
+// it even again. A reader that sees the same even sequence before and after reading has
+// a consistent frame. The ring lets a reader fall back to the previous frame instead of
+// spinning while the newest one is being written.
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const char * const SHARED_TOUCH_DEFAULT_NAME = "/kinect2touch";
+static const uint32_t SHARED_TOUCH_VERSION = 1;
+static const uint32_t SHARED_TOUCH_SLOTS = 4;
+static const uint32_t SHARED_TOUCH_MAX_TOUCHES = 64;
+static const uint32_t SHARED_TOUCH_MAX_FINGERTIPS = 256;
+
+struct SharedTouch {
+    int32_t id;
+    float x, y;                 // depth image pixels
+    float vx, vy;               // depth pixels per second
+    float projectedX, projectedY;   // projector pixels, valid if isProjected
+    int32_t isProjected;
+    float age;                  // seconds
+};
+
+struct SharedFingertip {
+    float x, y;                 // depth image pixels
+    float worldX, worldY, worldZ;   // mm, depth camera coordinates
+    int32_t zone;               // 0 outside, 1 hover, 2 touch
+    int32_t height;             // mm above the surface
+    int32_t blobIndex;
+};
+
+struct SharedTouchFrameData {
+    uint64_t frameNum;
+    uint64_t timestamp;         // sensor frame time, microseconds
+    uint64_t publishTime;       // std::chrono::steady_clock microseconds when the frame was written
+    uint32_t numTouches;
+    uint32_t numFingertips;
+    SharedTouch touches[SHARED_TOUCH_MAX_TOUCHES];
+    SharedFingertip fingertips[SHARED_TOUCH_MAX_FINGERTIPS];
+};
+
+struct alignas(64) SharedTouchSlot {
+    std::atomic<uint32_t> sequence;     // odd while being written
+    SharedTouchFrameData frame;
+};
+
+struct SharedTouchRegion {
+    char magic[4];              // "K2TS"
+    uint32_t version;
+    uint32_t numSlots;
+    uint32_t frameSize;         // sizeof(SharedTouchFrameData), catches mismatched builds
+    std::atomic<uint64_t> latest;       // frameNum of the newest complete frame, 0 before the first
+    SharedTouchSlot slots[SHARED_TOUCH_SLOTS];
+};
+
+// Polls the touch ring published by kinect2touch.
+//
+//   SharedTouchReader reader;
+//   reader.open();
+//   SharedTouchFrameData frame;
+//   if (reader.read(frame)) ...
+//
+class SharedTouchReader {
+public:
+
+    ~SharedTouchReader(){ close(); }
+
+    bool open(const char * name = SHARED_TOUCH_DEFAULT_NAME){
+        close();
+        int fd = shm_open(name, O_RDONLY, 0);
+        if (fd < 0) return false;
+        // a region from a build with a smaller layout, or one still being sized by the
+        // publisher, would fault on first read instead of failing the checks below
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(SharedTouchRegion)){
+            ::close(fd);
+            return false;
+        }
+        void * ptr = mmap(NULL, sizeof(SharedTouchRegion), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (ptr == MAP_FAILED) return false;
+        region = (const SharedTouchRegion *)ptr;
+        if (memcmp(region->magic, "K2TS", 4) != 0 || region->version != SHARED_TOUCH_VERSION ||
+            region->numSlots != SHARED_TOUCH_SLOTS || region->frameSize != sizeof(SharedTouchFrameData)){
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close(){
+        if (region) munmap((void *)region, sizeof(SharedTouchRegion));
+        region = NULL;
+    }
+
+    bool isOpen() const { return region != NULL; }
+
+    // frameNum of the newest published frame, 0 if nothing was published yet
+    uint64_t getLatestFrameNum() const{
+        return region ? region->latest.load(std::memory_order_acquire) : 0;
+    }
+
+    // Calls fn(const SharedTouchFrameData &) on the newest consistent frame in place, without
+    // copying it. fn may see a frame that is being overwritten, so it must only read and must
+    // not keep pointers; its result only counts when this returns true.
+    template <class F>
+    bool peek(F fn) const{
+        if (!region) return false;
+        uint64_t latest = region->latest.load(std::memory_order_acquire);
+        if (latest == 0) return false;
+
+        // newest first, then the older slots if the writer is lapping us
+        for (uint64_t n = latest; n > 0 && n + SHARED_TOUCH_SLOTS > latest; n--){
+            const SharedTouchSlot & slot = region->slots[n % SHARED_TOUCH_SLOTS];
+            uint32_t before = slot.sequence.load(std::memory_order_acquire);
+            if (before & 1) continue;
+            fn(slot.frame);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == before && slot.frame.frameNum == n)
+                return true;
+        }
+        return false;
+    }
+
+    // copies out the newest consistent frame, only the touches and fingertips in use
+    bool read(SharedTouchFrameData & out) const{
+        return peek([&](const SharedTouchFrameData & frame){
+            out.frameNum = frame.frameNum;
+            out.timestamp = frame.timestamp;
+            out.publishTime = frame.publishTime;
+            out.numTouches = frame.numTouches < SHARED_TOUCH_MAX_TOUCHES ? frame.numTouches : SHARED_TOUCH_MAX_TOUCHES;
+            out.numFingertips = frame.numFingertips < SHARED_TOUCH_MAX_FINGERTIPS ? frame.numFingertips : SHARED_TOUCH_MAX_FINGERTIPS;
+            memcpy(out.touches, frame.touches, out.numTouches * sizeof(SharedTouch));
+            memcpy(out.fingertips, frame.fingertips, out.numFingertips * sizeof(SharedFingertip));
+        });
+    }
+
+private:
+
+    const SharedTouchRegion * region = NULL;
+
+};
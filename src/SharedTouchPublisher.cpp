@@ -0,0 +1,109 @@
+#include "SharedTouchPublisher.h"
+
+#include <chrono>
+
+
+SharedTouchPublisher::~SharedTouchPublisher(){
+    close();
+}
+
+bool SharedTouchPublisher::open(string name){
+
+    close();
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0){
+        ofLogError("SharedTouchPublisher") << "couldn't create shared memory " << name;
+        return false;
+    }
+    if (ftruncate(fd, sizeof(SharedTouchRegion)) != 0){
+        ofLogError("SharedTouchPublisher") << "couldn't size shared memory " << name;
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    void * ptr = mmap(NULL, sizeof(SharedTouchRegion), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (ptr == MAP_FAILED){
+        ofLogError("SharedTouchPublisher") << "couldn't map shared memory " << name;
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    // readers check the header before anything else, so fill it in last
+    region = (SharedTouchRegion *)ptr;
+    memset(region->magic, 0, sizeof(region->magic));
+    region->latest.store(0, std::memory_order_relaxed);
+    for (auto & slot : region->slots){
+        slot.sequence.store(0, std::memory_order_relaxed);
+        slot.frame.frameNum = 0;
+    }
+    region->version = SHARED_TOUCH_VERSION;
+    region->numSlots = SHARED_TOUCH_SLOTS;
+    region->frameSize = sizeof(SharedTouchFrameData);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(region->magic, "K2TS", 4);
+
+    this->name = name;
+    ofLogNotice("SharedTouchPublisher") << "publishing touches to " << name;
+    return true;
+}
+
+void SharedTouchPublisher::close(){
+    if (!region) return;
+    munmap(region, sizeof(SharedTouchRegion));
+    shm_unlink(name.c_str());
+    region = NULL;
+}
+
+void SharedTouchPublisher::publish(uint64_t frameNum, uint64_t timestamp, const vector<Touch> & touches, const vector<Fingertip> & fingertips){
+
+    if (!region) return;
+
+    SharedTouchSlot & slot = region->slots[frameNum % SHARED_TOUCH_SLOTS];
+    SharedTouchFrameData & frame = slot.frame;
+
+    // odd while writing
+    uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    frame.frameNum = frameNum;
+    frame.timestamp = timestamp;
+    frame.publishTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    uint32_t n = 0;
+    for (auto & touch : touches){
+        if (!touch.bConfirmed) continue;
+        if (n == SHARED_TOUCH_MAX_TOUCHES) break;
+        SharedTouch & t = frame.touches[n++];
+        t.id = touch.id;
+        t.x = touch.position.x;
+        t.y = touch.position.y;
+        t.vx = touch.velocity.x;
+        t.vy = touch.velocity.y;
+        t.projectedX = touch.projected.x;
+        t.projectedY = touch.projected.y;
+        t.isProjected = touch.bProjected;
+        t.age = touch.age;
+    }
+    frame.numTouches = n;
+
+    n = MIN(fingertips.size(), SHARED_TOUCH_MAX_FINGERTIPS);
+    for (uint32_t i=0; i<n; i++){
+        const Fingertip & tip = fingertips[i];
+        SharedFingertip & t = frame.fingertips[i];
+        t.x = tip.position.x;
+        t.y = tip.position.y;
+        t.worldX = tip.world.x;
+        t.worldY = tip.world.y;
+        t.worldZ = tip.world.z;
+        t.zone = tip.zone;
+        t.height = tip.height;
+        t.blobIndex = tip.blobIndex;
+    }
+    frame.numFingertips = n;
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    region->latest.store(frameNum, std::memory_order_release);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "ofMain.h"
+#include "SharedTouchFrame.h"
+#include "TouchTracker.h"
+#include "FingertipDetector.h"
+
+// Writes every processed frame's touches into the POSIX shared-memory ring described in
+// SharedTouchFrame.h, for consumers on the same machine that can't afford a socket.
+// The region is created on open() and unlinked again on close().
+class SharedTouchPublisher {
+public:
+
+    ~SharedTouchPublisher();
+
+    bool open(string name = SHARED_TOUCH_DEFAULT_NAME);
+    void close();
+    bool isOpen() const { return region != NULL; }
+
+    // frameNum must increase from 1, touches and fingertips past the slot's capacity are dropped
+    void publish(uint64_t frameNum, uint64_t timestamp, const vector<Touch> & touches, const vector<Fingertip> & fingertips);
+
+    string name;
+
+private:
+
+    SharedTouchRegion * region = NULL;
+
+};
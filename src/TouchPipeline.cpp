@@ -0,0 +1,529 @@
+#include "TouchPipeline.h"
+#include "DepthThreshold.h"
+#include "Trace.h"
+
+const char * getLatencyStageName(int stage){
+    static const char * names[NUM_LATENCY_STAGES] = {"threshold", "blobs", "fingertips", "touch", "publish", "total"};
+    return stage >= 0 && stage < NUM_LATENCY_STAGES ? names[stage] : "";
+}
+
+void TouchPipeline::setup(DepthSource * source, WorkerPool * workers){
+
+    this->source = source;
+    this->workers = workers;
+    tracker.setup(source->getWidth(), source->getHeight());
+    rays.setupKinect(source->getWidth(), source->getHeight(), source->getZeroPlanePixelSize(), source->getZeroPlaneDistance());
+
+    ofLogNotice("TouchPipeline") << "depth thresholding with " << DepthThreshold::getInstructionSet();
+}
+
+void TouchPipeline::threadedFunction(){
+
+    TRACE_THREAD_NAME("processing");
+
+    while (isThreadRunning()){
+        if (!processNext())
+            sleep(1);
+    }
+}
+
+bool TouchPipeline::processNext(){
+
+    source->update();
+    if (!source->isFrameNew()) return false;
+
+    TRACE_SCOPE("frame");
+    lastMark = ofGetElapsedTimeMicros();
+    frames.getBack().receivedTime = lastMark;
+
+    lock();
+    current = settings;
+    if (recorder.isRecording())
+        recorder.addFrame(*source);
+    if (backgroundRequest > 0){
+        background.learn(source->getWidth(), source->getHeight(), backgroundRequest);
+        backgroundRequest = 0;
+    }
+    unlock();
+
+    if (background.isLearning()){
+        background.addFrame(source->getRawDepthPixels());
+        if (background.isReady())
+            background.save("background.png");
+    }
+    bLearningBackground = background.isLearning();
+
+    if (isStatic()){
+        held.frameNum = ++frameCount;
+        held.timestamp = source->getFrameTimestamp();
+        sendTuio(held);
+        shareTouches(held);
+        return true;
+    }
+
+    TouchFrame & frame = frames.getBack();
+    process(frame);
+    sendTuio(frame);
+    shareTouches(frame);
+    updateLatency(frame);
+
+    held.touches = frame.touches;
+    held.fingertips = frame.fingertips;
+    frames.publish();
+    return true;
+}
+
+// True if the gate finds nothing moved since the last processed frame. Even then a frame is
+// processed every GATE_MAX_SKIPPED, so settings changes and touch ages still catch up.
+bool TouchPipeline::isStatic(){
+
+    if (!current.bFrameGate){
+        gate.reset();
+        gateSkipped = 0;
+        return false;
+    }
+
+    TRACE_SCOPE("frame gate");
+    // only the part of the frame that would be processed
+    updateROI();
+    bool changed = gate.isChanged(source->getRawDepthPixels(), roi, current.gateNoiseMm, current.gateMinPixels);
+    if (!changed && gateSkipped < GATE_MAX_SKIPPED){
+        gateSkipped++;
+        skippedFrames++;
+        return true;
+    }
+
+    gate.setReference();
+    gateSkipped = 0;
+    return false;
+}
+
+void TouchPipeline::setSettings(const TouchSettings & settings){
+    lock();
+    this->settings = settings;
+    unlock();
+}
+
+bool TouchPipeline::update(){
+    return frames.update();
+}
+
+TouchFrame & TouchPipeline::getFrame(){
+    return frames.getFront();
+}
+
+ofVec3f TouchPipeline::getWorldCoordinateAt(const TouchFrame & frame, int x, int y){
+
+    if (!frame.rawDepth.isAllocated() || x < 0 || y < 0 || x >= frame.rawDepth.getWidth() || y >= frame.rawDepth.getHeight())
+        return ofVec3f();
+
+    return rays.getWorldCoordinateAt(x, y, frame.rawDepth[y * frame.rawDepth.getWidth() + x]);
+}
+
+void TouchPipeline::learnBackground(int numFrames){
+    lock();
+    backgroundRequest = numFrames;
+    bLearningBackground = true;
+    unlock();
+}
+
+bool TouchPipeline::loadBackground(string filePath){
+
+    if (!ofFile::doesFileExist(filePath)) return false;
+
+    BackgroundModel loaded;
+    if (!loaded.load(filePath)) return false;
+
+    const ofShortPixels & pix = loaded.background;
+    if (pix.getWidth() != source->getWidth() || pix.getHeight() != source->getHeight() || pix.getNumChannels() != 1){
+        ofLogWarning("TouchPipeline") << filePath << " is " << pix.getWidth() << "x" << pix.getHeight() << "x" << pix.getNumChannels()
+            << ", not the source's " << source->getWidth() << "x" << source->getHeight() << ", learning a new background";
+        return false;
+    }
+
+    background = loaded;
+    ofLogNotice("TouchPipeline") << "loaded background from " << filePath;
+    return true;
+}
+
+bool TouchPipeline::isLearningBackground(){
+    lock();
+    bool learning = backgroundRequest > 0 || bLearningBackground;
+    unlock();
+    return learning;
+}
+
+void TouchPipeline::startRecording(string filePath){
+    lock();
+    recorder.open(filePath, *source);
+    unlock();
+}
+
+void TouchPipeline::stopRecording(){
+    lock();
+    recorder.close();
+    unlock();
+}
+
+bool TouchPipeline::isRecording(){
+    lock();
+    bool recording = recorder.isRecording();
+    unlock();
+    return recording;
+}
+
+void TouchPipeline::updateROI(){
+
+    int w = source->getWidth();
+    int h = source->getHeight();
+
+    ofRectangle next(0, 0, w, h);
+    bool masked = current.bUseROI && current.workspacePlane2D.size() >= 3;
+
+    if (masked){
+        ofRectangle bounds = current.workspacePlane2D.getBoundingBox();
+        int x0 = ofClamp(floor(bounds.x) - current.roiMargin, 0, w);
+        int y0 = ofClamp(floor(bounds.y) - current.roiMargin, 0, h);
+        int x1 = ofClamp(ceil(bounds.getRight()) + current.roiMargin, 0, w);
+        int y1 = ofClamp(ceil(bounds.getBottom()) + current.roiMargin, 0, h);
+
+        if (x1 > x0 && y1 > y0)
+            next.set(x0, y0, x1 - x0, y1 - y0);
+        else
+            masked = false;
+    }
+
+    bool polygonChanged = masked && roiPolygon.getVertices() != current.workspacePlane2D.getVertices();
+    if (next == roi && masked == bMasked && !polygonChanged) return;
+
+    roi = next;
+    bMasked = masked;
+    roiPolygon = current.workspacePlane2D;
+
+    // precompute which roi pixels fall inside the workspace polygon
+    if (bMasked){
+        roiMask.allocate(roi.width, roi.height, OF_PIXELS_GRAY);
+        unsigned char * mask = roiMask.getData();
+        for (int y=0; y<roi.height; y++){
+            for (int x=0; x<roi.width; x++){
+                *mask++ = roiPolygon.inside(roi.x + x + 0.5f, roi.y + y + 0.5f) ? 255 : 0;
+            }
+        }
+    }
+    else{
+        roiMask.clear();
+    }
+
+    ofLogNotice("TouchPipeline") << "processing roi " << roi;
+}
+
+void TouchPipeline::process(TouchFrame & frame){
+
+    frame.frameNum = ++frameCount;
+    frame.timestamp = source->getFrameTimestamp();
+
+    frame.depth.setFromPixels(source->getDepthPixels().getData(), source->getWidth(), source->getHeight(), OF_PIXELS_GRAY);
+    frame.rawDepth.setFromPixels(source->getRawDepthPixels().getData(), source->getWidth(), source->getHeight(), OF_PIXELS_GRAY);
+    if (source->getPixels().isAllocated())
+        frame.color.setFromPixels(source->getPixels().getData(), source->getWidth(), source->getHeight(), OF_PIXELS_RGB);
+
+    updateROI();
+
+    int roiW = roi.width;
+    int roiH = roi.height;
+
+    // height above the workspace surface for the whole roi, shared by thresholding,
+    // the touch test and the debug view; filled in with the thresholded rows
+    if (current.zone.isDefined()){
+        ofVec3f normal;
+        float d;
+        current.zone.getSurfacePlane(normal, d);
+        heightMap.setup(rays, normal, d);
+        frame.height.resize((size_t)roiW * roiH);
+    }
+    else{
+        frame.height.clear();
+    }
+
+    // tiled, bands of rows go to the workers
+    frame.thresholded.allocate(roiW, roiH, OF_PIXELS_GRAY);
+    if (current.bTiled && workers)
+        workers->parallelFor(roiH, [this, &frame](size_t begin, size_t end){
+            thresholdRows(frame, begin, end);
+        }, 16);
+    else
+        thresholdRows(frame, 0, roiH);
+    markStage(LATENCY_THRESHOLD);
+
+    frame.roi = roi;
+
+    // find blobs between minArea and maxArea pixels, offset back into full frame coordinates
+    blobFinder.workers = current.bTiled ? workers : NULL;
+    blobFinder.findBlobs(frame.thresholded.getData(), roiW, roiH, current.minArea, current.maxArea, current.maxBlobs, roi.x, roi.y);
+    // swapped rather than copied, the finder refills whatever this slot held last time
+    frame.blobs.swap(blobFinder.blobs);
+    markStage(LATENCY_BLOBS);
+
+    // fingertips along the contour of every blob in the workspace, one blob per worker at a time,
+    // then gathered in blob order so the result doesn't depend on which worker finished first.
+    // A blob too small or too round for a k-curvature tip stands in with its centroid, so a
+    // fingertip seen end on still reaches the touch test
+    fingertips.k = current.fingertipK;
+    fingertips.maxAngle = current.fingertipMaxAngle;
+    size_t numBlobs = frame.blobs.size();
+    if (blobTips.size() < numBlobs)
+        blobTips.resize(numBlobs);
+
+    auto findTips = [this, &frame](size_t begin, size_t end){
+        bool hasWorkspace = current.workspacePlane2D.size() >= 3;
+        for (size_t i=begin; i<end; i++){
+            blobTips[i].clear();
+            if (hasWorkspace && !current.workspacePlane2D.inside(frame.blobs[i].centroid)) continue;
+            if (fingertips.find(frame.blobs[i], i, blobTips[i]) == 0){
+                Fingertip centroid;
+                centroid.position.set(lround(frame.blobs[i].centroid.x), lround(frame.blobs[i].centroid.y));
+                centroid.angle = 180;
+                centroid.blobIndex = i;
+                blobTips[i].push_back(centroid);
+            }
+        }
+    };
+    if (workers)
+        workers->parallelFor(numBlobs, findTips);
+    else
+        findTips(0, numBlobs);
+
+    frame.fingertips.clear();
+    for (size_t i=0; i<numBlobs; i++)
+        frame.fingertips.insert(frame.fingertips.end(), blobTips[i].begin(), blobTips[i].end());
+
+    // the finger point is the sharpest tip on the largest blob
+    const Fingertip * finger = NULL;
+    for (auto &tip : frame.fingertips){
+        if (tip.blobIndex == 0 && (finger == NULL || tip.angle < finger->angle))
+            finger = &tip;
+    }
+    // a frame without one keeps the last detection, as the calibration clicks expect
+    if (finger){
+        fingerPt2D = finger->position;
+        fingerPt = getWorldCoordinateAt(frame, fingerPt2D.x, fingerPt2D.y);
+    }
+    frame.fingerPt = fingerPt;
+    frame.fingerPt2D = fingerPt2D;
+    markStage(LATENCY_FINGERTIPS);
+
+    checkForTouch(frame);
+    markStage(LATENCY_TOUCH);
+}
+
+// Thresholds rows [begin, end) of the roi, masking out everything outside the workspace
+// in the same pass, after filling in their heights when the surface is known.
+void TouchPipeline::thresholdRows(TouchFrame & frame, int begin, int end){
+
+    int w = source->getWidth();
+    int roiX = roi.x;
+    int roiY = roi.y;
+    int roiW = roi.width;
+
+    // rows the map can't fill come back as NO_HEIGHT, which the zone test never calls a touch
+    bool hasPlane = current.zone.isDefined();
+    if (hasPlane)
+        heightMap.updateRows(frame.rawDepth, roi, frame.height.data(), begin, end);
+
+    for (int y=begin; y<end; y++){
+
+        size_t src = (size_t)(roiY + y) * w + roiX;
+        unsigned char * dst = frame.thresholded.getData() + y * roiW;
+        const unsigned char * mask = bMasked ? roiMask.getData() + y * roiW : NULL;
+
+        if (current.bUsePlaneHeight && hasPlane)
+            DepthThreshold::heightRange(frame.height.data() + y * roiW, dst, roiW, current.minHeightMm, current.maxHeightMm, mask);
+        else if (current.bUseBackground && background.isReady())
+            DepthThreshold::heightBand(frame.rawDepth.getData() + src, background.background.getData() + src, dst, roiW, current.minHeightMm, current.maxHeightMm, mask);
+        else if (current.bUseRawDepth)
+            DepthThreshold::bandRaw(frame.rawDepth.getData() + src, dst, roiW, current.nearThresholdMm, current.farThresholdMm, mask);
+        else
+            DepthThreshold::band(frame.depth.getData() + src, dst, roiW, current.nearThreshold, current.farThreshold, mask);
+    }
+}
+
+void TouchPipeline::checkForTouch(TouchFrame & frame){
+
+    frame.hasTouch = false;
+    frame.touchIndices.clear();
+    touchPoints.clear();
+    touchBlobs.clear();
+
+    if (current.zone.isDefined()){
+
+        // decide by height above the surface, read from the frame's height map;
+        // the zone planes only decide whether a fingertip is inside the sides
+        size_t n = frame.fingertips.size();
+        tipX.resize(n);
+        tipY.resize(n);
+        tipZ.resize(n);
+        tipHeights.resize(n);
+        tipZones.resize(n);
+        for (size_t i=0; i<n; i++){
+            Fingertip & tip = frame.fingertips[i];
+            tip.world = getWorldCoordinateAt(frame, tip.position.x, tip.position.y);
+            int x = tip.position.x - frame.roi.x;
+            int y = tip.position.y - frame.roi.y;
+            tip.height = frame.height[y * (int)frame.roi.width + x];
+            tipX[i] = tip.world.x;
+            tipY[i] = tip.world.y;
+            tipZ[i] = tip.world.z;
+            tipHeights[i] = tip.height;
+        }
+        current.zone.classify(tipX.data(), tipY.data(), tipZ.data(), tipHeights.data(), n, tipZones.data());
+
+        for (size_t i=0; i<n; i++){
+            Fingertip & tip = frame.fingertips[i];
+            tip.zone = tipZones[i];
+            if (tip.zone != InteractionZone::TOUCH) continue;
+
+            touchPoints.push_back(tip.position);
+            touchBlobs.push_back(tip.blobIndex);
+            if (frame.touchIndices.empty() || frame.touchIndices.back() != tip.blobIndex)
+                frame.touchIndices.push_back(tip.blobIndex);
+        }
+    }
+    else{
+
+        // no zone yet, fall back to blob centroids inside the 2D workspace
+        for (int i=0; i< frame.blobs.size(); i++){
+
+            if (current.workspacePlane2D.inside(frame.blobs[i].centroid)){
+                frame.touchIndices.push_back(i);
+                touchPoints.push_back(frame.blobs[i].centroid);
+                touchBlobs.push_back(i);
+            }
+        }
+    }
+
+    frame.hasTouch = !frame.touchIndices.empty();
+
+    // follow the touches across frames
+    tracker.birthFrames = current.touchBirthFrames;
+    tracker.deathFrames = current.touchDeathFrames;
+    tracker.matchDistance = current.touchMatchDistance;
+    tracker.update(touchPoints, touchBlobs, frame.timestamp);
+    tracker.getTouches(frame.touches);
+
+    // and where they are on the projector
+    updateProjectorLUT();
+    for (Touch & touch : frame.touches){
+        int x = lround(touch.position.x);
+        int y = lround(touch.position.y);
+        touch.bProjected = projector.isAllocated() && projector.map(x, y, touch.projected) &&
+            projector.mapVelocity(x, y, touch.velocity, touch.projectedVelocity);
+    }
+}
+
+void TouchPipeline::updateProjectorLUT(){
+
+    if (!current.bHasProjectorModel || !current.zone.isDefined()){
+        projector.clear();
+        return;
+    }
+
+    ofVec3f normal;
+    float d;
+    current.zone.getSurfacePlane(normal, d);
+
+    // only rebuilt when the surface or the calibration changes
+    if (projector.isAllocated() && normal == projectorNormal && d == projectorD &&
+        memcmp(&current.projectorModel, &projectorModel, sizeof(projectorModel)) == 0)
+        return;
+
+    projectorNormal = normal;
+    projectorD = d;
+    projectorModel = current.projectorModel;
+    TRACE_SCOPE("ProjectorLUT::setup");
+    projector.setup(rays, normal, d, projectorModel);
+}
+
+void TouchPipeline::sendTuio(const TouchFrame & frame){
+
+    TRACE_SCOPE("sendTuio");
+
+    if (!current.bSendTuio){
+        tuio.close();
+        tuio.port = 0;
+        return;
+    }
+
+    // (re)open when the destination changes, a failed address isn't retried every frame
+    if (tuio.port != current.tuioPort || tuio.host != current.tuioHost){
+        tuio.setup(current.tuioHost, current.tuioPort);
+        tuio.host = current.tuioHost;
+        tuio.port = current.tuioPort;
+    }
+    if (!tuio.isConnected()) return;
+
+    ofVec2f depthSize(source->getWidth(), source->getHeight());
+    ofVec2f projectorSize(current.projectorModel.width, current.projectorModel.height);
+    tuio.send(frame.touches, (int32_t)frame.frameNum, depthSize, projectorSize);
+}
+
+void TouchPipeline::shareTouches(const TouchFrame & frame){
+
+    TRACE_SCOPE("shareTouches");
+
+    if (!current.bShareTouches){
+        sharedTouches.close();
+        bShareFailed = false;
+        return;
+    }
+
+    // a region that couldn't be created isn't retried every frame
+    if (!sharedTouches.isOpen()){
+        if (bShareFailed) return;
+        bShareFailed = !sharedTouches.open();
+        if (bShareFailed) return;
+    }
+
+    sharedTouches.publish(frame.frameNum, frame.timestamp, frame.touches, frame.fingertips);
+}
+
+void TouchPipeline::markStage(LatencyStage stage){
+    uint64_t now = ofGetElapsedTimeMicros();
+    latency[stage].record(now - lastMark);
+#if KINECT2TOUCH_TRACE
+    // the stages double as trace spans, shifted onto the trace clock
+    uint64_t traceNow = Trace::now();
+    Trace::record(getLatencyStageName(stage), traceNow - (now - lastMark), traceNow);
+#endif
+    lastMark = now;
+}
+
+void TouchPipeline::updateLatency(TouchFrame & frame){
+
+    markStage(LATENCY_PUBLISH);
+    frame.publishedTime = lastMark;
+    latency[LATENCY_TOTAL].record(frame.publishedTime - frame.receivedTime);
+
+    // summarise, log and start over every few seconds
+    if (latencyWindowStart == 0) latencyWindowStart = lastMark;
+    if (lastMark - latencyWindowStart >= LATENCY_LOG_INTERVAL){
+        uint64_t count = latency[LATENCY_TOTAL].getCount();
+        for (int i=0; i<NUM_LATENCY_STAGES; i++){
+            latencySummary[i] = latency[i].getPercentiles();
+            latency[i].reset();
+        }
+
+        // only built when it will be shown, so a quiet log never allocates here
+        if (ofGetLogLevel("TouchPipeline") <= OF_LOG_NOTICE){
+            stringstream ss;
+            ss << "p50/p95/p99 us over " << count << " frames:";
+            for (int i=0; i<NUM_LATENCY_STAGES; i++)
+                ss << " " << getLatencyStageName(i) << " " << latencySummary[i].p50 << "/" << latencySummary[i].p95 << "/" << latencySummary[i].p99;
+            ss << ", " << skippedFrames << " static frames skipped";
+            ofLogNotice("TouchPipeline") << ss.str();
+        }
+        latencyWindowStart = lastMark;
+    }
+
+    for (int i=0; i<NUM_LATENCY_STAGES; i++)
+        frame.latency[i] = latencySummary[i];
+}
@@ -0,0 +1,239 @@
+#pragma once
+
+#include "ofMain.h"
+#include "BlobFinder.h"
+#include "FingertipDetector.h"
+#include "TouchTracker.h"
+#include "RayLUT.h"
+#include "InteractionZone.h"
+#include "HeightMap.h"
+#include "ProjectorLUT.h"
+#include "TuioSender.h"
+#include "SharedTouchPublisher.h"
+#include "LatencyHistogram.h"
+#include "DepthSource.h"
+#include "DepthRecorder.h"
+#include "BackgroundModel.h"
+#include "FrameGate.h"
+#include "TripleBuffer.h"
+#include "WorkerPool.h"
+
+// GUI values the processing thread works from; the app hands over a fresh copy every update().
+struct TouchSettings {
+    int nearThreshold = 255;
+    int farThreshold = 234;
+    int minArea = 1500;
+    int maxArea = 15000;
+    int maxBlobs = 64;
+
+    // threshold the raw 16-bit depth in millimetres instead of the 8-bit depth image
+    bool bUseRawDepth = false;
+    int nearThresholdMm = 500;
+    int farThresholdMm = 1000;
+
+    // segment by height above the learned background instead of a global band
+    bool bUseBackground = false;
+    int minHeightMm = 10;
+    int maxHeightMm = 60;
+
+    // segment by height above the workspace surface (min/maxHeightMm), once the zone is defined
+    bool bUsePlaneHeight = false;
+
+    // only process the workspace bounding box (plus a margin) once the workspace is defined
+    bool bUseROI = true;
+    int roiMargin = 20;
+
+    // threshold and label in horizontal bands across the worker pool, for large frames
+    bool bTiled = false;
+
+    // skip processing while the scene is static: a frame where fewer than gateMinPixels roi pixels
+    // moved by more than gateNoiseMm since the last processed one keeps that frame's result
+    // (see FrameGate). Kept well under a fingertip, so a single press still gets through.
+    bool bFrameGate = false;
+    int gateNoiseMm = 8;
+    int gateMinPixels = 100;
+
+    // touch tracking: frames to confirm a new touch, frames a lost touch is kept, match radius in pixels
+    int touchBirthFrames = 3;
+    int touchDeathFrames = 5;
+    float touchMatchDistance = 40;
+
+    // fingertips: k-curvature step along the contour and the widest tip angle in degrees
+    int fingertipK = 20;
+    float fingertipMaxAngle = 60;
+
+    ofPolyline workspacePlane2D;
+
+    // once the workspace is defined, fingertips touch when they're inside this zone and
+    // within its touch height of the surface
+    InteractionZone zone;
+
+    // the solved projector model, maps touches on the surface to projector pixels
+    bool bHasProjectorModel = false;
+    CalibrationFileHeader projectorModel = {};
+
+    // TUIO 1.1 cursors to other processes, one bundle per frame
+    bool bSendTuio = false;
+    string tuioHost = "127.0.0.1";
+    int tuioPort = 3333;
+
+    // every frame's touches and fingertips in shared memory, see SharedTouchFrame.h
+    bool bShareTouches = false;
+};
+
+// Stages of a frame timed for the latency overlay and log, each from the end of the one before.
+enum LatencyStage {
+    LATENCY_THRESHOLD = 0,  // frame arrived to thresholded, including the copy and the height map
+    LATENCY_BLOBS,
+    LATENCY_FINGERTIPS,
+    LATENCY_TOUCH,          // zone test and tracking
+    LATENCY_PUBLISH,        // TUIO, shared memory
+    LATENCY_TOTAL,          // frame arrived to handed to the render thread
+    NUM_LATENCY_STAGES
+};
+
+const char * getLatencyStageName(int stage);
+
+// Everything the processing thread produces for one depth frame.
+struct TouchFrame {
+    uint64_t frameNum = 0;
+    uint64_t timestamp = 0;     // sensor frame time in microseconds
+
+    ofPixels depth;             // 8-bit depth, near = white
+    ofShortPixels rawDepth;     // 16-bit depth in mm
+    ofPixels color;
+    ofPixels thresholded;       // covers only the roi
+    ofRectangle roi;            // part of the depth frame that was processed
+    vector<short> height;       // mm above the workspace surface, roi sized, empty until the zone is defined
+
+    vector<Blob> blobs;
+    vector<Fingertip> fingertips;   // every tip on every blob
+    ofVec3f fingerPt;           // the last one detected, this frame or an earlier one
+    ofVec3f fingerPt2D;
+
+    bool hasTouch = false;
+    vector<int> touchIndices;
+    vector<Touch> touches;      // tracked touches with stable ids
+
+    // ofGetElapsedTimeMicros() when the frame came in and when it was handed over
+    uint64_t receivedTime = 0;
+    uint64_t publishedTime = 0;
+    LatencyPercentiles latency[NUM_LATENCY_STAGES];     // over the last logging interval
+};
+
+// Runs thresholding, contour finding, fingertip and touch detection on its own thread,
+// as frames arrive from the depth source. Results are handed to the render thread through
+// a triple buffer, so draw() never waits on processing and processing never waits on draw().
+class TouchPipeline : public ofThread {
+public:
+
+    // per-blob work is spread across workers when given one, shared with the render thread
+    void setup(DepthSource * source, WorkerPool * workers = NULL);
+    void threadedFunction();
+
+    // one pass of the processing loop, returns false if the source had no new frame.
+    // Runs on the processing thread, or on its own when the thread isn't started (see bench/).
+    // Once the buffers have grown to the scene, a frame allocates nothing.
+    bool processNext();
+
+    void setSettings(const TouchSettings & settings);
+
+    // render thread: picks up the latest result, returns true if it changed
+    bool update();
+    TouchFrame & getFrame();
+
+    ofVec3f getWorldCoordinateAt(const TouchFrame & frame, int x, int y);
+
+    // per-pixel rays of the depth camera, for converting whole frames to world coordinates
+    const RayLUT & getRays() const { return rays; }
+
+    // average the next numFrames frames into a new background (saved to background.png)
+    void learnBackground(int numFrames);
+    // the background saved by an earlier run, before the thread starts; false if there is
+    // none or it doesn't match the source's resolution
+    bool loadBackground(string filePath);
+    bool isLearningBackground();
+
+    void startRecording(string filePath);
+    void stopRecording();
+    bool isRecording();
+
+    // frames the gate found static and skipped, since setup
+    uint64_t getSkippedFrames() const { return skippedFrames; }
+
+    DepthSource * source = NULL;
+    WorkerPool * workers = NULL;
+
+private:
+
+    void updateROI();
+    bool isStatic();
+    void process(TouchFrame & frame);
+    void thresholdRows(TouchFrame & frame, int begin, int end);
+    void checkForTouch(TouchFrame & frame);
+    void updateProjectorLUT();
+    void sendTuio(const TouchFrame & frame);
+    void shareTouches(const TouchFrame & frame);
+
+    // records the time since the previous mark against stage
+    void markStage(LatencyStage stage);
+    void updateLatency(TouchFrame & frame);
+
+    TouchSettings settings;         // guarded by the thread mutex
+    TouchSettings current;          // processing thread's copy
+
+    RayLUT rays;
+    HeightMap heightMap;
+
+    ProjectorLUT projector;
+    ofVec3f projectorNormal;            // surface and model the lut was built for
+    float projectorD = 0;
+    CalibrationFileHeader projectorModel = {};
+
+    ofRectangle roi;
+    ofPolyline roiPolygon;              // workspace the mask was built from
+    ofPixels roiMask;                   // 255 inside the workspace polygon, roi sized
+    bool bMasked = false;
+
+    BlobFinder blobFinder;
+    FingertipDetector fingertips;
+    vector<vector<Fingertip>> blobTips;     // each blob's tips, so blobs can be searched in parallel
+    ofVec3f fingerPt;                       // last detected finger point, held across frames without one
+    ofVec3f fingerPt2D;
+
+    TouchTracker tracker;
+    vector<ofPoint> touchPoints;    // what the tracker follows, and the blob each came from
+    vector<int> touchBlobs;
+
+    vector<float> tipX, tipY, tipZ; // fingertip world positions and heights for the zone test
+    vector<short> tipHeights;
+    vector<unsigned char> tipZones;
+
+    TuioSender tuio;
+    SharedTouchPublisher sharedTouches;
+    bool bShareFailed = false;
+
+    LatencyHistogram latency[NUM_LATENCY_STAGES];
+    LatencyPercentiles latencySummary[NUM_LATENCY_STAGES];
+    uint64_t lastMark = 0;
+    uint64_t latencyWindowStart = 0;
+    static const uint64_t LATENCY_LOG_INTERVAL = 5000000;     // microseconds
+
+    TripleBuffer<TouchFrame> frames;
+    uint64_t frameCount = 0;
+
+    // a skipped frame publishes nothing, so the render thread keeps the last result,
+    // and the outputs are sent the touches held from it
+    FrameGate gate;
+    TouchFrame held;                // only the touches, fingertips and frame numbers
+    int gateSkipped = 0;            // in a row
+    std::atomic<uint64_t> skippedFrames{0};
+    static const int GATE_MAX_SKIPPED = 30;     // a frame is processed at least this often anyway
+
+    DepthRecorder recorder;         // guarded by the thread mutex
+
+    BackgroundModel background;
+    int backgroundRequest = 0;      // guarded by the thread mutex
+    std::atomic<bool> bLearningBackground{false};
+
+};
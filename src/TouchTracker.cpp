@@ -0,0 +1,154 @@
+#include "TouchTracker.h"
+
+
+void TouchTracker::setup(int width, int height){
+
+    this->width = width;
+    this->height = height;
+    cellSize = 0;
+    touches.clear();
+}
+
+int TouchTracker::getCell(const ofPoint & pt) const{
+
+    int col = ofClamp(floor(pt.x / cellSize), 0, cols - 1);
+    int row = ofClamp(floor(pt.y / cellSize), 0, rows - 1);
+    return row * cols + col;
+}
+
+void TouchTracker::update(const vector<ofPoint> & points, const vector<int> & blobIndices, uint64_t timestamp){
+
+    float dt = (lastTimestamp > 0 && timestamp > lastTimestamp) ? (timestamp - lastTimestamp) / 1000000.0f : 0;
+
+    // time went backwards (a looping replay): move the birth times along so ages carry on
+    // from where they were instead of wrapping
+    if (timestamp < lastTimestamp){
+        for (auto &touch : touches){
+            uint64_t age = lastTimestamp - MIN(touch.birthTime, lastTimestamp);
+            touch.birthTime = timestamp - MIN(age, timestamp);
+        }
+    }
+    lastTimestamp = timestamp;
+
+    // cells are as big as the match distance, so any match is within the 3x3 cells around a touch
+    float size = MAX(matchDistance, 1.f);
+    if (size != cellSize){
+        cellSize = size;
+        cols = MAX(1, (int)ceil(width / cellSize));
+        rows = MAX(1, (int)ceil(height / cellSize));
+        cellStart.resize(cols * rows + 1);
+    }
+
+    // bucket the new points by cell (counting sort)
+    std::fill(cellStart.begin(), cellStart.end(), 0);
+    pointCell.resize(points.size());
+    for (int i=0; i<points.size(); i++){
+        pointCell[i] = getCell(points[i]);
+        cellStart[pointCell[i] + 1]++;
+    }
+    for (int c=0; c<cols * rows; c++)
+        cellStart[c + 1] += cellStart[c];
+
+    // fill using cellStart as a cursor, which leaves each entry at the next cell's start
+    cellPoints.resize(points.size());
+    for (int i=0; i<points.size(); i++)
+        cellPoints[cellStart[pointCell[i]]++] = i;
+    for (int c=cols * rows; c>0; c--)
+        cellStart[c] = cellStart[c - 1];
+    cellStart[0] = 0;
+
+    // candidate pairs between each touch's predicted position and nearby points
+    matches.clear();
+    predicted.resize(touches.size());
+    float maxDistSq = matchDistance * matchDistance;
+    for (int t=0; t<touches.size(); t++){
+
+        predicted[t] = touches[t].position + ofPoint(touches[t].velocity.x, touches[t].velocity.y) * dt;
+
+        int cell = getCell(predicted[t]);
+        int col = cell % cols;
+        int row = cell / cols;
+
+        for (int r=MAX(0, row - 1); r<=MIN(rows - 1, row + 1); r++){
+            for (int c=MAX(0, col - 1); c<=MIN(cols - 1, col + 1); c++){
+                int bucket = r * cols + c;
+                for (int k=cellStart[bucket]; k<cellStart[bucket + 1]; k++){
+                    int p = cellPoints[k];
+                    float distSq = predicted[t].squareDistance(points[p]);
+                    if (distSq <= maxDistSq)
+                        matches.push_back({distSq, t, p});
+                }
+            }
+        }
+    }
+
+    // closest pairs first
+    std::sort(matches.begin(), matches.end());
+
+    pointTouch.assign(points.size(), -1);
+    touchMatched.assign(touches.size(), false);
+    for (auto &match : matches){
+
+        if (touchMatched[match.touch] || pointTouch[match.point] >= 0) continue;
+        touchMatched[match.touch] = true;
+        pointTouch[match.point] = match.touch;
+
+        Touch & touch = touches[match.touch];
+        const ofPoint & pt = points[match.point];
+
+        // lightly smoothed, the centroid jitters by a pixel or two
+        if (dt > 0){
+            ofVec2f v((pt.x - touch.position.x) / dt, (pt.y - touch.position.y) / dt);
+            touch.velocity = touch.velocity.getInterpolated(v, 0.5);
+        }
+
+        touch.position = pt;
+        touch.blobIndex = blobIndices[match.point];
+        touch.framesSeen++;
+        touch.framesMissing = 0;
+
+        if (!touch.bConfirmed && touch.framesSeen >= birthFrames){
+            touch.bConfirmed = true;
+            touch.id = nextId++;
+        }
+    }
+
+    // touches nobody matched: keep them around for a while, candidates are dropped right away
+    for (int t=0; t<touches.size(); t++){
+        if (touchMatched[t]) continue;
+        touches[t].blobIndex = -1;
+        touches[t].framesMissing++;
+    }
+    touches.erase(std::remove_if(touches.begin(), touches.end(), [this](const Touch & touch){
+        return touch.framesMissing > (touch.bConfirmed ? deathFrames : 0);
+    }), touches.end());
+
+    // points nobody claimed start new candidates
+    for (int i=0; i<points.size(); i++){
+
+        if (pointTouch[i] >= 0) continue;
+
+        Touch touch;
+        touch.position = points[i];
+        touch.blobIndex = blobIndices[i];
+        touch.birthTime = timestamp;
+        touch.framesSeen = 1;
+        if (birthFrames <= 1){
+            touch.bConfirmed = true;
+            touch.id = nextId++;
+        }
+        touches.push_back(touch);
+    }
+
+    for (auto &touch : touches)
+        touch.age = (timestamp - touch.birthTime) / 1000000.0f;
+}
+
+void TouchTracker::getTouches(vector<Touch> & confirmed) const{
+
+    confirmed.clear();
+    for (auto &touch : touches){
+        if (touch.bConfirmed)
+            confirmed.push_back(touch);
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "ofMain.h"
+
+struct Touch {
+    int id = -1;                // stable across frames, assigned once the touch is confirmed
+    ofPoint position;           // depth image coordinates
+    ofVec2f velocity;           // pixels per second
+    float age = 0;              // seconds since first seen
+    int blobIndex = -1;         // index into this frame's blobs, -1 while the touch is missing
+
+    ofVec2f projected;          // projector pixel, once the calibration and the zone are set
+    ofVec2f projectedVelocity;  // projector pixels per second
+    bool bProjected = false;
+
+    uint64_t birthTime = 0;     // microseconds
+    int framesSeen = 0;
+    int framesMissing = 0;
+    bool bConfirmed = false;
+};
+
+// Follows touch points from frame to frame and gives each finger a stable id.
+// Points are matched to the predicted position of existing touches with a greedy nearest
+// neighbour search over a uniform grid, so the cost stays linear in the number of touches.
+// A new point has to be seen birthFrames frames in a row before it becomes a touch, and a
+// touch survives deathFrames missed frames before it is dropped.
+class TouchTracker {
+public:
+
+    void setup(int width, int height);
+
+    // points[i] came from blob blobIndices[i], timestamp in microseconds
+    void update(const vector<ofPoint> & points, const vector<int> & blobIndices, uint64_t timestamp);
+
+    // confirmed touches, including ones within their death grace period
+    void getTouches(vector<Touch> & confirmed) const;
+
+    int birthFrames = 3;
+    int deathFrames = 5;
+    float matchDistance = 40;   // pixels
+
+private:
+
+    struct Match {
+        float distSq;
+        int touch;
+        int point;
+        bool operator<(const Match & other) const { return distSq < other.distSq; }
+    };
+
+    int getCell(const ofPoint & pt) const;
+
+    vector<Touch> touches;
+    int nextId = 0;
+    uint64_t lastTimestamp = 0;
+
+    int width = 0, height = 0;
+    int cols = 0, rows = 0;
+    float cellSize = 0;
+    vector<int> cellStart;      // points bucketed by cell: cellStart[c] .. cellStart[c+1] in cellPoints
+    vector<int> cellPoints;
+    vector<int> pointCell;
+
+    vector<ofPoint> predicted;
+    vector<Match> matches;
+    vector<int> pointTouch;     // touch each point was assigned to, -1 if none
+    vector<bool> touchMatched;
+
+};
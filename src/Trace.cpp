@@ -0,0 +1,113 @@
+#include "Trace.h"
+#include "ofMain.h"
+
+#include <memory>
+#include <mutex>
+
+
+namespace {
+
+    // relaxed atomics so the dump can read while the thread writes, which costs nothing
+    // over plain stores on x86 and arm
+    struct Span {
+        std::atomic<const char *> name;
+        std::atomic<uint64_t> start;
+        std::atomic<uint32_t> duration;
+    };
+
+    // one per thread that ever traced, written only by its thread
+    struct ThreadBuffer {
+        std::atomic<uint64_t> count{0};
+        std::atomic<const char *> name{NULL};
+        int id = 0;
+        std::unique_ptr<Span[]> spans;
+    };
+
+    // buffers are never freed, a thread that has exited still shows up in the dump
+    std::mutex buffersMutex;
+    vector<ThreadBuffer *> buffers;
+
+    ThreadBuffer * getThreadBuffer(){
+        static thread_local ThreadBuffer * buffer = NULL;
+        if (!buffer){
+            buffer = new ThreadBuffer();
+            buffer->spans.reset(new Span[Trace::TRACE_CAPACITY]);
+            std::lock_guard<std::mutex> lock(buffersMutex);
+            buffer->id = buffers.size() + 1;
+            buffers.push_back(buffer);
+        }
+        return buffer;
+    }
+
+    void writeEscaped(FILE * file, const char * str){
+        for (; *str; str++){
+            if (*str == '"' || *str == '\\') fputc('\\', file);
+            fputc(*str, file);
+        }
+    }
+}
+
+void Trace::record(const char * name, uint64_t start, uint64_t end){
+    ThreadBuffer * buffer = getThreadBuffer();
+    uint64_t n = buffer->count.load(std::memory_order_relaxed);
+    Span & span = buffer->spans[n & (TRACE_CAPACITY - 1)];
+    span.name.store(name, std::memory_order_relaxed);
+    span.start.store(start, std::memory_order_relaxed);
+    span.duration.store(end - start, std::memory_order_relaxed);
+    buffer->count.store(n + 1, std::memory_order_release);
+}
+
+void Trace::setThreadName(const char * name){
+    getThreadBuffer()->name = name;
+}
+
+bool Trace::dump(std::string filePath, float seconds){
+
+    FILE * file = fopen(ofToDataPath(filePath).c_str(), "w");
+    if (!file){
+        ofLogError("Trace") << "couldn't write " << filePath;
+        return false;
+    }
+
+    uint64_t from = now() - (uint64_t)(seconds * 1000000);
+    size_t written = 0;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    bool first = true;
+    for (ThreadBuffer * buffer : buffers){
+
+        const char * name = buffer->name;
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"", first ? "" : ",\n", buffer->id);
+        writeEscaped(file, name ? name : "thread");
+        fprintf(file, "\"}}");
+        first = false;
+
+        uint64_t end = buffer->count.load(std::memory_order_acquire);
+        uint64_t begin = end > TRACE_CAPACITY ? end - TRACE_CAPACITY : 0;
+        for (uint64_t i=begin; i<end; i++){
+            const Span & span = buffer->spans[i & (TRACE_CAPACITY - 1)];
+            const char * spanName = span.name.load(std::memory_order_relaxed);
+            uint64_t start = span.start.load(std::memory_order_relaxed);
+            uint32_t duration = span.duration.load(std::memory_order_relaxed);
+
+            // the thread keeps recording while we write the file; skip anything it has
+            // lapped since, the slot may hold a newer span by now
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (buffer->count.load(std::memory_order_relaxed) >= i + TRACE_CAPACITY) continue;
+
+            if (start < from) continue;
+            fprintf(file, ",\n{\"name\":\"");
+            writeEscaped(file, spanName);
+            fprintf(file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%llu,\"dur\":%u}", buffer->id, (unsigned long long)start, duration);
+            written++;
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    ofLogNotice("Trace") << "wrote " << written << " spans from the last " << seconds << "s to " << filePath;
+    return true;
+}
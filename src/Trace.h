@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Scoped trace markers, dumped as Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+//
+//   void TouchPipeline::process(...){
+//       TRACE_SCOPE("process");
+//       ...
+//
+// Each thread records into its own ring buffer, so a marker is two clock reads and a store,
+// no locks. The rings keep the last TRACE_CAPACITY spans per thread; Trace::dump() writes
+// whichever of those fall in the last few seconds. Build with KINECT2TOUCH_TRACE=0 to
+// compile every marker out.
+
+#ifndef KINECT2TOUCH_TRACE
+    #define KINECT2TOUCH_TRACE 1
+#endif
+
+namespace Trace {
+
+    static const uint32_t TRACE_CAPACITY = 1 << 16;     // spans per thread, a power of two
+
+    inline uint64_t now(){
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // name must be a string literal (or otherwise outlive the dump), start and end from now()
+    void record(const char * name, uint64_t start, uint64_t end);
+
+    // shown as the track name, call once from the thread
+    void setThreadName(const char * name);
+
+    // writes the spans of every thread that started in the last `seconds`, returns false on failure
+    bool dump(std::string filePath, float seconds);
+
+    struct Scope {
+        const char * name;
+        uint64_t start;
+        Scope(const char * name) : name(name), start(now()) {}
+        ~Scope(){ record(name, start, now()); }
+    };
+}
+
+#if KINECT2TOUCH_TRACE
+    #define TRACE_CONCAT_(a, b) a##b
+    #define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+    #define TRACE_SCOPE(name) Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
+    #define TRACE_THREAD_NAME(name) Trace::setThreadName(name)
+#else
+    #define TRACE_SCOPE(name)
+    #define TRACE_THREAD_NAME(name)
+#endif
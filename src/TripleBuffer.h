@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+
+// Lock-free single producer / single consumer triple buffer.
+// The writer fills getBack() and publish()es it; the reader calls update() to pick up the
+// newest published slot and reads getFront() until its next update(). Neither side ever
+// blocks or sees a half-written value, and the reader only ever gets the most recent result.
+template<class T>
+class TripleBuffer {
+public:
+
+    // writer side
+    T & getBack(){
+        return buffers[back];
+    }
+
+    void publish(){
+        int previous = middle.exchange(back | FRESH, std::memory_order_acq_rel);
+        back = previous & INDEX;
+    }
+
+    // reader side, returns true if a new value was picked up
+    bool update(){
+        if (!(middle.load(std::memory_order_acquire) & FRESH)) return false;
+        int previous = middle.exchange(front, std::memory_order_acq_rel);
+        front = previous & INDEX;
+        return true;
+    }
+
+    const T & getFront() const {
+        return buffers[front];
+    }
+
+    T & getFront(){
+        return buffers[front];
+    }
+
+    T buffers[3];
+
+private:
+
+    static const int INDEX = 3;
+    static const int FRESH = 4;
+
+    int back = 0;
+    int front = 1;
+    std::atomic<int> middle{2};
+
+};
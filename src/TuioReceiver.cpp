@@ -0,0 +1,144 @@
+#include "TuioReceiver.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+
+namespace {
+
+    // OSC string length including its zero padding, 0 if it runs off the end
+    size_t paddedLength(const char * data, size_t size){
+        size_t len = strnlen(data, size);
+        if (len == size) return 0;
+        size_t padded = (len + 4) & ~(size_t)3;
+        return padded <= size ? padded : 0;
+    }
+
+    int32_t readInt(const char * data){
+        uint32_t v;
+        memcpy(&v, data, 4);
+        return (int32_t)ntohl(v);
+    }
+
+    float readFloat(const char * data){
+        int32_t bits = readInt(data);
+        float f;
+        memcpy(&f, &bits, 4);
+        return f;
+    }
+}
+
+TuioReceiver::~TuioReceiver(){
+    close();
+}
+
+bool TuioReceiver::setup(int port){
+
+    close();
+
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0){
+        ofLogError("TuioReceiver") << "couldn't create socket";
+        return false;
+    }
+
+    sockaddr_in addr = sockaddr_in();
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sock, (sockaddr *)&addr, sizeof(addr)) != 0){
+        ofLogError("TuioReceiver") << "couldn't bind port " << port;
+        close();
+        return false;
+    }
+
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+    buffer.resize(65536);
+    return true;
+}
+
+void TuioReceiver::close(){
+    if (sock >= 0)
+        ::close(sock);
+    sock = -1;
+}
+
+bool TuioReceiver::update(){
+
+    if (sock < 0) return false;
+
+    bool received = false;
+    ssize_t n;
+    while ((n = recv(sock, buffer.data(), buffer.size(), 0)) > 0)
+        received |= parseBundle(buffer.data(), n);
+
+    return received;
+}
+
+bool TuioReceiver::parseBundle(const char * data, size_t size){
+
+    if (size < 16 || memcmp(data, "#bundle", 8) != 0) return false;
+
+    cursors.clear();
+    alive.clear();
+
+    // skip the timetag
+    size_t pos = 16;
+    while (pos + 4 <= size){
+        int32_t length = readInt(data + pos);
+        pos += 4;
+        if (length < 0 || pos + length > size) return false;
+        if (!parseMessage(data + pos, length)) return false;
+        pos += length;
+    }
+    return true;
+}
+
+bool TuioReceiver::parseMessage(const char * data, size_t size){
+
+    size_t addressLength = paddedLength(data, size);
+    if (!addressLength) return false;
+    if (strcmp(data, "/tuio/2Dcur") != 0) return true;     // other profiles are ignored
+
+    const char * tags = data + addressLength;
+    size_t tagsLength = paddedLength(tags, size - addressLength);
+    if (!tagsLength || tags[0] != ',' || tags[1] != 's') return false;
+
+    const char * args = tags + tagsLength;
+    const char * end = data + size;
+    size_t commandLength = paddedLength(args, end - args);
+    if (!commandLength) return false;
+    const char * command = args;
+    args += commandLength;
+
+    size_t numArgs = strlen(tags) - 2;
+    if (strcmp(command, "source") == 0){
+        size_t len = paddedLength(args, end - args);
+        if (!len) return false;
+        source = args;
+    }
+    else if (strcmp(command, "alive") == 0){
+        if (args + numArgs * 4 > end) return false;
+        for (size_t i=0; i<numArgs; i++)
+            alive.push_back(readInt(args + i * 4));
+    }
+    else if (strcmp(command, "set") == 0){
+        if (strcmp(tags, ",sifffff") != 0 || args + 24 > end) return false;
+        TuioCursor cursor;
+        cursor.id = readInt(args);
+        cursor.x = readFloat(args + 4);
+        cursor.y = readFloat(args + 8);
+        cursor.vx = readFloat(args + 12);
+        cursor.vy = readFloat(args + 16);
+        cursor.accel = readFloat(args + 20);
+        cursors.push_back(cursor);
+    }
+    else if (strcmp(command, "fseq") == 0){
+        if (args + 4 > end) return false;
+        frameSeq = readInt(args);
+    }
+    return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "ofMain.h"
+
+struct TuioCursor {
+    int id = -1;
+    float x = 0, y = 0;     // normalised 0-1
+    float vx = 0, vy = 0;   // normalised units per second
+    float accel = 0;
+};
+
+// Minimal TUIO 1.1 /tuio/2Dcur listener: just enough to read back what TuioSender sends,
+// for checking the output on the same machine without a full TUIO client.
+class TuioReceiver {
+public:
+
+    ~TuioReceiver();
+
+    bool setup(int port);
+    void close();
+
+    // drains the socket without blocking, keeping the newest bundle.
+    // Returns true if one arrived, cursors are then the set messages of that bundle.
+    bool update();
+
+    vector<TuioCursor> cursors;
+    vector<int> alive;
+    int32_t frameSeq = -1;
+    string source;
+
+private:
+
+    bool parseBundle(const char * data, size_t size);
+    bool parseMessage(const char * data, size_t size);
+
+    int sock = -1;
+    vector<char> buffer;
+
+};
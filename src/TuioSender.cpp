@@ -0,0 +1,167 @@
+#include "TuioSender.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+
+TuioSender::~TuioSender(){
+    close();
+}
+
+bool TuioSender::setup(string host, int port){
+
+    close();
+
+    sockaddr_in addr = sockaddr_in();
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1){
+        ofLogError("TuioSender") << "not an IPv4 address: " << host;
+        return false;
+    }
+
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0){
+        ofLogError("TuioSender") << "couldn't create socket";
+        return false;
+    }
+
+    // connected, so every frame is a plain send() with no address lookup
+    if (connect(sock, (sockaddr *)&addr, sizeof(addr)) != 0){
+        ofLogError("TuioSender") << "couldn't connect to " << host << ":" << port;
+        close();
+        return false;
+    }
+
+    this->host = host;
+    this->port = port;
+
+    buffer.resize(MAX_PACKET_SIZE);
+    aliveTags.reserve(MAX_PACKET_SIZE);
+    source = "kinect2touch@" + host;
+
+    ofLogNotice("TuioSender") << "sending TUIO to " << host << ":" << port;
+    return true;
+}
+
+void TuioSender::close(){
+    if (sock >= 0)
+        ::close(sock);
+    sock = -1;
+}
+
+bool TuioSender::writeInt(int32_t value){
+    if (size + 4 > buffer.size()) return false;
+    uint32_t v = htonl((uint32_t)value);
+    memcpy(&buffer[size], &v, 4);
+    size += 4;
+    return true;
+}
+
+bool TuioSender::writeFloat(float value){
+    int32_t bits;
+    memcpy(&bits, &value, 4);
+    return writeInt(bits);
+}
+
+bool TuioSender::writeString(const char * str){
+    // at least one terminating zero, then zeros up to the next multiple of 4
+    size_t len = strlen(str);
+    size_t padded = (len + 4) & ~(size_t)3;
+    if (size + padded > buffer.size()) return false;
+    memcpy(&buffer[size], str, len);
+    memset(&buffer[size + len], 0, padded - len);
+    size += padded;
+    return true;
+}
+
+bool TuioSender::beginMessage(const char * address, const char * typeTags){
+    messageStart = size;
+    return writeInt(0) && writeString(address) && writeString(typeTags);
+}
+
+void TuioSender::endMessage(){
+    uint32_t length = htonl((uint32_t)(size - messageStart - 4));
+    memcpy(&buffer[messageStart], &length, 4);
+}
+
+bool TuioSender::send(const vector<Touch> & touches, int32_t frameSeq, const ofVec2f & depthSize, const ofVec2f & projectorSize){
+
+    if (sock < 0) return false;
+
+    size = 0;
+
+    // bundle header, timetag 1 = immediately
+    writeString("#bundle");
+    writeInt(0);
+    writeInt(1);
+
+    beginMessage("/tuio/2Dcur", ",ss");
+    writeString("source");
+    writeString(source.c_str());
+    endMessage();
+
+    // leave room for every set message plus fseq, so alive never lists a touch that isn't set
+    const size_t setSize = 4 + 12 + 12 + 4 + 4 + 5 * 4;
+    const size_t fseqSize = 4 + 12 + 4 + 8 + 4;
+    int numTouches = 0;
+    for (auto & touch : touches)
+        numTouches += touch.bConfirmed;
+    int maxTouches = numTouches;
+    while (maxTouches > 0 && size + 4 + 12 + ((maxTouches + 7) & ~3) + 8 + maxTouches * (4 + setSize) + fseqSize > buffer.size())
+        maxTouches--;
+    if (maxTouches < numTouches)
+        ofLogWarning("TuioSender") << "bundle full, sending " << maxTouches << " of " << numTouches << " touches";
+
+    aliveTags.assign(",s");
+    aliveTags.append(maxTouches, 'i');
+    beginMessage("/tuio/2Dcur", aliveTags.c_str());
+    writeString("alive");
+    int n = 0;
+    for (auto & touch : touches){
+        if (!touch.bConfirmed) continue;
+        if (n++ == maxTouches) break;
+        writeInt(touch.id);
+    }
+    endMessage();
+
+    n = 0;
+    for (auto & touch : touches){
+        if (!touch.bConfirmed) continue;
+        if (n++ == maxTouches) break;
+
+        // position and velocity in the same units, so consumers can integrate one into the other
+        float x, y, vx, vy;
+        if (touch.bProjected){
+            x = touch.projected.x / projectorSize.x;
+            y = touch.projected.y / projectorSize.y;
+            vx = touch.projectedVelocity.x / projectorSize.x;
+            vy = touch.projectedVelocity.y / projectorSize.y;
+        }
+        else{
+            x = touch.position.x / depthSize.x;
+            y = touch.position.y / depthSize.y;
+            vx = touch.velocity.x / depthSize.x;
+            vy = touch.velocity.y / depthSize.y;
+        }
+
+        beginMessage("/tuio/2Dcur", ",sifffff");
+        writeString("set");
+        writeInt(touch.id);
+        writeFloat(x);
+        writeFloat(y);
+        writeFloat(vx);
+        writeFloat(vy);
+        writeFloat(0);
+        endMessage();
+    }
+
+    beginMessage("/tuio/2Dcur", ",si");
+    writeString("fseq");
+    writeInt(frameSeq);
+    endMessage();
+
+    return ::send(sock, buffer.data(), size, 0) == (ssize_t)size;
+}
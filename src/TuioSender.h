@@ -0,0 +1,48 @@
+#pragma once
+
+#include "ofMain.h"
+#include "TouchTracker.h"
+
+// Sends touches as TUIO 1.1 2D cursors (/tuio/2Dcur) over UDP, so content apps can run
+// as separate processes. Each frame is one OSC bundle holding source, alive, a set per
+// confirmed touch and fseq, encoded by hand into a buffer allocated once in setup().
+class TuioSender {
+public:
+
+    ~TuioSender();
+
+    bool setup(string host, int port);
+    void close();
+    bool isConnected() const { return sock >= 0; }
+
+    // Positions are normalised to 0-1: projector pixels over projectorSize for touches that
+    // map onto the projector, otherwise depth pixels over depthSize. Returns false if the
+    // bundle couldn't be sent.
+    bool send(const vector<Touch> & touches, int32_t frameSeq, const ofVec2f & depthSize, const ofVec2f & projectorSize);
+
+    string host;
+    int port = 0;
+
+    // fits well over a hundred cursors, further touches are left out of the bundle
+    static const size_t MAX_PACKET_SIZE = 8192;
+
+private:
+
+    // OSC encoding, big endian and padded to 4 bytes; all return false when the buffer is full
+    bool writeInt(int32_t value);
+    bool writeFloat(float value);
+    bool writeString(const char * str);
+
+    // starts a bundle element, the size is filled in by endMessage()
+    bool beginMessage(const char * address, const char * typeTags);
+    void endMessage();
+
+    int sock = -1;
+    vector<char> buffer;
+    size_t size = 0;
+    size_t messageStart = 0;
+
+    string source;
+    string aliveTags;
+
+};
@@ -0,0 +1,90 @@
+#include "WorkerPool.h"
+#include <algorithm>
+
+
+WorkerPool::~WorkerPool(){
+    close();
+}
+
+void WorkerPool::setup(int numThreads){
+
+    close();
+
+    if (numThreads <= 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+    bExit = false;
+    for (int i=0; i<numThreads; i++)
+        threads.push_back(std::thread(&WorkerPool::worker, this, generation));
+}
+
+void WorkerPool::close(){
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        bExit = true;
+    }
+    wake.notify_all();
+
+    for (auto &thread : threads)
+        thread.join();
+    threads.clear();
+}
+
+void WorkerPool::parallelFor(size_t count, const std::function<void(size_t, size_t)> & fn, size_t grain){
+
+    if (count == 0) return;
+
+    std::unique_lock<std::mutex> owner(busy, std::try_to_lock);
+    if (threads.empty() || count <= grain || !owner.owns_lock()){
+        fn(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &fn;
+        jobCount = count;
+        // a few chunks per thread, so uneven work still balances out
+        chunkSize = std::max(grain, count / (getNumThreads() * 4) + 1);
+        nextChunk = 0;
+        pending = threads.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    runChunks();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this]{ return pending == 0; });
+    job = NULL;
+}
+
+void WorkerPool::runChunks(){
+
+    while (true){
+        size_t begin = nextChunk.fetch_add(chunkSize);
+        if (begin >= jobCount) break;
+        (*job)(begin, std::min(begin + chunkSize, jobCount));
+    }
+}
+
+void WorkerPool::worker(uint64_t seen){
+
+    std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+    while (true){
+
+        lock.lock();
+        wake.wait(lock, [&]{ return bExit || generation != seen; });
+        if (bExit) return;
+        seen = generation;
+        lock.unlock();
+
+        runChunks();
+
+        lock.lock();
+        if (--pending == 0)
+            done.notify_one();
+        lock.unlock();
+    }
+}
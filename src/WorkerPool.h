@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads for splitting loops across cores.
+// parallelFor() hands out chunks of [0, count) to the workers and the calling thread,
+// and returns once every chunk is done. One loop runs at a time: if the pool is already
+// busy with another thread's loop, the caller just runs its loop itself.
+class WorkerPool {
+public:
+
+    ~WorkerPool();
+
+    // numThreads workers besides the caller, 0 = one per core less the caller
+    void setup(int numThreads = 0);
+    void close();
+
+    // fn(begin, end) is called on non-overlapping ranges covering [0, count),
+    // at least grain items at a time
+    void parallelFor(size_t count, const std::function<void(size_t begin, size_t end)> & fn, size_t grain = 1);
+
+    int getNumThreads() const { return threads.size() + 1; }
+
+private:
+
+    void worker(uint64_t seen);     // seen = last generation handled
+    void runChunks();
+
+    std::vector<std::thread> threads;
+    std::mutex busy;                // held for the whole of a parallelFor
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    uint64_t generation = 0;
+    int pending = 0;
+    bool bExit = false;
+
+    const std::function<void(size_t, size_t)> * job = NULL;
+    size_t jobCount = 0;
+    size_t chunkSize = 1;
+    std::atomic<size_t> nextChunk{0};
+
+};
@@ -1,6 +1,23 @@
 #include "ofApp.h"
 
-int main() {
+int main(int argc, char *argv[]) {
     ofSetupOpenGL(1600, 1200, OF_WINDOW);
-	ofRunApp(new ofApp());
+    
+    ofApp * app = new ofApp();
+    
+    // --replay <file.k2td> plays back a recorded session, --fast replays as fast as possible,
+    // --trace <seconds> writes a Chrome trace of the last seconds on exit
+    for (int i=1; i<argc; i++){
+        string arg = argv[i];
+        if (arg == "--replay" && i+1 < argc)
+            app->replayPath = argv[++i];
+        else if (arg == "--fast")
+            app->bReplayFast = true;
+        else if (arg == "--trace" && i+1 < argc){
+            app->traceSeconds = ofToFloat(argv[++i]);
+            app->bTraceOnExit = true;
+        }
+    }
+    
+	ofRunApp(app);
 }
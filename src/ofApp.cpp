@@ -1,4 +1,5 @@
 #include "ofApp.h"
+#include "DepthThreshold.h"
 
 
 /*
@@ -9,24 +10,16 @@
 //--------------------------------------------------------------
 void ofApp::setup() {
 	ofSetLogLevel(OF_LOG_VERBOSE);
+	TRACE_THREAD_NAME("main");
 	
-	// enable depth->video image calibration
-	kinect.setRegistration(true);
-    
-	kinect.init();
-	//kinect.init(true); // shows infrared instead of RGB video image
-	//kinect.init(false, false); // disable video image (faster fps)
-	
-	kinect.open();		// opens first available kinect
-	//kinect.open(1);	// open a kinect by id, starting with 0 (sorted by serial # lexicographically))
-	//kinect.open("A00362A08602047A");	// open a kinect using it's unique serial #
-	
-	// print the intrinsic IR sensor values
-	if(kinect.isConnected()) {
-		ofLogNotice() << "sensor-emitter dist: " << kinect.getSensorEmitterDistance() << "cm";
-		ofLogNotice() << "sensor-camera dist:  " << kinect.getSensorCameraDistance() << "cm";
-		ofLogNotice() << "zero plane pixel size: " << kinect.getZeroPlanePixelSize() << "mm";
-		ofLogNotice() << "zero plane dist: " << kinect.getZeroPlaneDistance() << "mm";
+	if (!replayPath.empty() && replaySource.load(replayPath)){
+		// play back a recorded session instead of the sensor
+		replaySource.bRealtime = !bReplayFast;
+		source = &replaySource;
+	}
+	else{
+		kinectSource.open();
+		source = &kinectSource;
 	}
 	
 #ifdef USE_TWO_KINECTS
@@ -34,20 +27,19 @@ void ofApp::setup() {
 	kinect2.open();
 #endif
 	
-	colorImg.allocate(kinect.width, kinect.height);
-	grayImage.allocate(kinect.width, kinect.height);
-	grayThreshNear.allocate(kinect.width, kinect.height);
-	grayThreshFar.allocate(kinect.width, kinect.height);
+	colorImg.allocate(source->getWidth(), source->getHeight());
+	
+	workers.setup();
+	pointCloud.setup(source->getWidth(), source->getHeight(), 2, &workers);
 	
 	nearThreshold = 230;
 	farThreshold = 70;
-	bThreshWithOpenCV = true;
 	
 	ofSetFrameRate(60);
 	
 	// zero the tilt on startup
 	angle = 0;
-	kinect.setCameraTiltAngle(angle);
+	kinectSource.kinect.setCameraTiltAngle(angle);
 	
 	// start from the front
 	bDrawPointCloud = false;
@@ -56,12 +48,17 @@ void ofApp::setup() {
     
     setupGUI();
     
+    // start processing depth frames as they arrive
+    pipeline.setup(source, &workers);
+    updateTouchSettings();
+    // relearning assumes the table is clear at startup, so only when there's no saved background
+    if (!pipeline.loadBackground("background.png"))
+        pipeline.learnBackground(backgroundFrames);
+    pipeline.startThread();
+    
     if (useCalibrated){
-        readCalibrationFiles("imagePts.txt", "worldPts.txt");
         calibration.setup( 1024, 768); //  cameraWidth		= 1024; cameraHeight	= 768;
-        calibration.loadPoints(imagePoints, worldPoints);
-        calibration.correctCamera();
-        
+        loadCalibration();
     }
     
     if (!hasCornerPoints || !hasFingerPoints){
@@ -86,77 +83,44 @@ void ofApp::setup() {
 //--------------------------------------------------------------
 void ofApp::update() {
 	
+	TRACE_SCOPE("update");
 	ofBackground(100, 100, 100);
 	
-	kinect.update();
-    
-    
-	// there is a new frame and we are connected
-	if(kinect.isFrameNew()) {
-		
-		// load grayscale depth image from the kinect source
-		grayImage.setFromPixels(kinect.getDepthPixels());
-		
-		// we do two thresholds - one for the far plane and one for the near plane
-		// we then do a cvAnd to get the pixels which are a union of the two thresholds
-		if(bThreshWithOpenCV) {
-			grayThreshNear = grayImage;
-			grayThreshFar = grayImage;
-			grayThreshNear.threshold(nearThreshold, true);
-			grayThreshFar.threshold(farThreshold);
-			cvAnd(grayThreshNear.getCvImage(), grayThreshFar.getCvImage(), grayImage.getCvImage(), NULL);
-		} else {
-			
-			// or we do it ourselves - show people how they can work with the pixels
-			ofPixels & pix = grayImage.getPixels();
-			int numPixels = pix.size();
-			for(int i = 0; i < numPixels; i++) {
-				if(pix[i] < nearThreshold && pix[i] > farThreshold) {
-					pix[i] = 255;
-				} else {
-					pix[i] = 0;
-				}
-			}
+	updateTouchSettings();
+	
+	// pick up the newest processed frame
+	if (pipeline.update()) {
+		TRACE_SCOPE("update: new frame");
+		TouchFrame & frame = pipeline.getFrame();
+		uint64_t now = ofGetElapsedTimeMicros();
+		displayLatency.record(now - frame.publishedTime);
+		if (displayWindowStart == 0) displayWindowStart = now;
+		if (now - displayWindowStart >= 5000000){
+			displayPercentiles = displayLatency.getPercentiles();
+			displayLatency.reset();
+			displayWindowStart = now;
+			ofLogNotice("ofApp") << "display latency p50/p95/p99 us: " << displayPercentiles.p50 << "/" << displayPercentiles.p95 << "/" << displayPercentiles.p99;
+		}
+		depthTexture.loadData(frame.depth);
+		// the roi changes size when the workspace is redefined
+		if (threshTexture.getWidth() != frame.thresholded.getWidth() || threshTexture.getHeight() != frame.thresholded.getHeight())
+			threshTexture.allocate(frame.thresholded);
+		if (bDrawHeight && frame.height.size() == frame.thresholded.getWidth() * frame.thresholded.getHeight()){
+			// 1 mm per grey level around mid grey, black where there's no reading
+			heightPixels.allocate(frame.thresholded.getWidth(), frame.thresholded.getHeight(), OF_PIXELS_GRAY);
+			for (size_t i=0; i<frame.height.size(); i++)
+				heightPixels[i] = frame.height[i] == DepthThreshold::NO_HEIGHT ? 0 : ofClamp(128 + frame.height[i], 1, 255);
+			threshTexture.loadData(heightPixels);
+		}
+		else
+			threshTexture.loadData(frame.thresholded);
+		if (frame.color.isAllocated())
+			colorTexture.loadData(frame.color);
+		// keep the points between the bottom and top of the interaction zone
+		if (bDrawPointCloud){
+			TRACE_SCOPE("update: point cloud");
+			pointCloud.update(frame.rawDepth, frame.color, pipeline.getRays(), btmCentroid.z, topCentroid.z);
 		}
-		
-		// update the cv images
-		grayImage.flagImageChanged();
-		
-		// find contours which are between the size of 20 pixels and 1/3 the w*h pixels.
-		// also, find holes is set to true so we will get interior contours as well....
-		contourFinder.findContours(grayImage, minArea, maxArea, 20, false);
-        
-        // update finger point
-        if (contourFinder.nBlobs > 0){
-            
-            hull = convexHull.getConvexHull(contourFinder.blobs[0].pts);
-
-            // remove duplicate points
-            vector<ofPoint> temp;
-            for (int i=0; i<hull.size()-1; i++){
-                
-                auto pt00 = hull[i];
-                auto pt01 = hull[i+1];
-                
-                float dist = 15;
-                if (pt00.squareDistance(pt01) > dist*dist){
-                    temp.push_back(pt00);
-                    i++;
-                }
-            }
-            
-            hull = temp;
-            
-            // assign finger point
-            fingerPt2D = hull[1];
-            fingerPt = kinect.getWorldCoordinateAt(fingerPt2D.x, fingerPt2D.y);
-            
-        }
-        
-        
-        checkForTouch();
-        
-        
 	}
     
     mouse.x = mouseX;
@@ -167,12 +131,53 @@ void ofApp::update() {
 #endif
 }
 
+//--------------------------------------------------------------
+void ofApp::updateTouchSettings() {
+	
+	// hand the latest gui values to the processing thread
+	touchSettings.nearThreshold = nearThreshold;
+	touchSettings.farThreshold = farThreshold;
+	touchSettings.bUseRawDepth = useRawDepth;
+	touchSettings.nearThresholdMm = nearThresholdMm;
+	touchSettings.farThresholdMm = farThresholdMm;
+	touchSettings.bUseBackground = useBackground;
+	touchSettings.minHeightMm = minHeightMm;
+	touchSettings.maxHeightMm = maxHeightMm;
+	touchSettings.bUsePlaneHeight = usePlaneHeight;
+	touchSettings.bUseROI = useROI;
+	touchSettings.roiMargin = roiMargin;
+	touchSettings.bTiled = tiledProcessing;
+	touchSettings.bFrameGate = frameGate;
+	touchSettings.gateNoiseMm = gateNoiseMm;
+	touchSettings.gateMinPixels = gateMinPixels;
+	touchSettings.minArea = minArea;
+	touchSettings.maxArea = maxArea;
+	touchSettings.touchBirthFrames = touchBirthFrames;
+	touchSettings.touchDeathFrames = touchDeathFrames;
+	touchSettings.touchMatchDistance = touchMatchDistance;
+	touchSettings.fingertipK = fingertipK;
+	touchSettings.fingertipMaxAngle = fingertipMaxAngle;
+	touchSettings.bSendTuio = sendTuio;
+	touchSettings.tuioPort = tuioPort;
+	touchSettings.bShareTouches = shareTouches;
+	touchSettings.workspacePlane2D = workspacePlane2D;
+	touchSettings.zone = zone;
+	touchSettings.zone.touchHeight = touchHeight;
+	touchSettings.bHasProjectorModel = isCalibrated && calibrationFile.header.hasSolution;
+	touchSettings.projectorModel = calibrationFile.header;
+	pipeline.setSettings(touchSettings);
+}
+
 //--------------------------------------------------------------
 void ofApp::draw() {
 	
+	TRACE_SCOPE("draw");
+	TouchFrame & frame = pipeline.getFrame();
+	
 	ofSetColor(255, 255, 255);
 	
 	if(bDrawPointCloud) {
+		TRACE_SCOPE("draw: point cloud");
 		easyCam.begin();
 		drawPointCloud();
         
@@ -185,6 +190,7 @@ void ofApp::draw() {
 		easyCam.end();
     }else if (bDrawProjector){
         
+        TRACE_SCOPE("draw: projector");
         ofPushStyle();
         ofBackground(0);
         
@@ -234,6 +240,13 @@ void ofApp::draw() {
 
         }
         
+        // draw the touches where the projector puts them
+        ofSetColor(ofColor::cyan);
+        for (auto &touch : pipeline.getFrame().touches){
+            if (touch.bProjected && touch.bConfirmed)
+                ofDrawCircle(touch.projected, 15);
+        }
+        
         // draw mouse cross hairs
         ofSetLineWidth(5);
         ofSetColor(ofColor::white);
@@ -247,7 +260,7 @@ void ofApp::draw() {
         // draw text feedback
         stringstream ss;
         ss << "Sceen Pt: {" << ofToString(mouseX) << ", " << ofToString(mouseY) << "}\n" <<
-            "World Pt: {" << ofToString(fingerPt) << "}\n\n" <<
+            "World Pt: {" << ofToString(frame.fingerPt) << "}\n\n" <<
             "Calibration Point Count: " << calibCount
         ;
         
@@ -257,49 +270,74 @@ void ofApp::draw() {
         
     }
     else {
-		// draw from the live kinect
-		kinect.drawDepth(10, 10, kinect.width, kinect.height);
+		// draw from the depth source
+		if (depthTexture.isAllocated()){
+			TRACE_SCOPE("draw: depth");
+			depthTexture.draw(10, 10, source->getWidth(), source->getHeight());
+		}
         
         // draw the 2D workspace
         drawWorkspace(false);
         
-        if(hasTouch){
+        if(frame.hasTouch){
+            TRACE_SCOPE("draw: touches");
             ofPushMatrix();
 //            ofPushStyle();
             ofTranslate(10,10);
-            for (auto &index : touchIndices)
-                contourFinder.blobs[index].draw();
+            for (auto &index : frame.touchIndices)
+                frame.blobs[index].draw();
 //            ofPopStyle();
             
+            // label the tracked touches with their ids
+            for (auto &touch : frame.touches){
+                if (touch.blobIndex < 0) continue;
+                ofDrawBitmapStringHighlight(ofToString(touch.id), touch.position.x + 10, touch.position.y - 10);
+            }
+            
             ofPopMatrix();
         }
         
         
-		kinect.draw(kinect.width + 20, 10, kinect.width, kinect.height);
+		if (colorTexture.isAllocated()){
+			TRACE_SCOPE("draw: color");
+			colorTexture.draw(source->getWidth() + 20, 10, source->getWidth(), source->getHeight());
+		}
 		
-		grayImage.draw(kinect.width + 20, kinect.height + 20, kinect.width, kinect.height);
+		if (threshTexture.isAllocated()){
+			TRACE_SCOPE("draw: threshold");
+			ofRectangle & roi = frame.roi;
+			threshTexture.draw(source->getWidth() + 20 + roi.x, source->getHeight() + 20 + roi.y, roi.width, roi.height);
+			
+			ofPushStyle();
+			ofNoFill();
+			ofSetColor(ofColor::magenta, 120);
+			ofDrawRectangle(source->getWidth() + 20 + roi.x, source->getHeight() + 20 + roi.y, roi.width, roi.height);
+			ofPopStyle();
+		}
         
         
-		contourFinder.draw(kinect.width + 20, kinect.height + 20, kinect.width, kinect.height);
+		{
+			TRACE_SCOPE("draw: blobs");
+			for (auto &blob : frame.blobs)
+				blob.draw(source->getWidth() + 20, source->getHeight() + 20);
+		}
+		
+		if (pipeline.isLearningBackground())
+			ofDrawBitmapStringHighlight("learning background, keep the table clear", source->getWidth() + 30, source->getHeight() + 40);
         
         ofPushMatrix();
         ofPushStyle();
         ofNoFill();
         ofSetLineWidth(3);
         ofSetColor(ofColor::aqua);
-        ofTranslate(kinect.width + 20, kinect.height + 20);
-        ofBeginShape();
-        for (auto &pt : hull)
-            ofVertex(pt);
-        ofEndShape();
-        
-        ofSetColor(ofColor::white);
-        for (int i=0; i<hull.size(); i++){
-            ofDrawBitmapString(ofToString(i), hull[i].x + 5, hull[i].y + 5);
+        ofTranslate(source->getWidth() + 20, source->getHeight() + 20);
+        for (auto &tip : frame.fingertips){
+            ofDrawCircle(tip.position, 5);
+            ofDrawLine(tip.position, tip.position + ofPoint(tip.direction.x, tip.direction.y) * 25);
         }
         
         ofSetColor(ofColor::magenta, 120);
-        ofDrawCircle(fingerPt2D, 10);
+        ofDrawCircle(frame.fingerPt2D, 10);
    
         ofPopStyle();
         ofPopMatrix();
@@ -309,37 +347,33 @@ void ofApp::draw() {
 #endif
 	}
 	
-	// draw instructions
 	ofSetColor(255, 255, 255);
-	stringstream reportStream;
-        
-    if(kinect.hasAccelControl()) {
-        reportStream << "accel is: " << ofToString(kinect.getMksAccel().x, 2) << " / "
-        << ofToString(kinect.getMksAccel().y, 2) << " / "
-        << ofToString(kinect.getMksAccel().z, 2) << endl;
-    } else {
-        reportStream << "Note: this is a newer Xbox Kinect or Kinect For Windows device," << endl
-		<< "motor / led / accel controls are not currently supported" << endl << endl;
-    }
-    
-	reportStream << "press p to switch between images and point cloud, rotate the point cloud with the mouse" << endl
-	<< "using opencv threshold = " << bThreshWithOpenCV <<" (press spacebar)" << endl
-	<< "set near threshold " << nearThreshold << " (press: + -)" << endl
-	<< "set far threshold " << farThreshold << " (press: < >) num blobs found " << contourFinder.nBlobs
-	<< ", fps: " << ofGetFrameRate() << endl
-	<< "press c to close the connection and o to open it again, connection is: " << kinect.isConnected() << endl;
-
-    if(kinect.hasCamTiltControl()) {
-    	reportStream << "press UP and DOWN to change the tilt angle: " << angle << " degrees" << endl
-        << "press 1-5 & 0 to change the led mode" << endl;
-    }
-    
-//	ofDrawBitmapString(reportStream.str(), 20, 652);
     
     if (!bDrawProjector){
+        TRACE_SCOPE("draw: gui");
         panelTouch.draw();
         panelCV.draw();
     }
+    
+    if (bDrawLatency)
+        drawLatency(frame);
+}
+
+//--------------------------------------------------------------
+void ofApp::drawLatency(const TouchFrame & frame){
+    
+    stringstream ss;
+    ss << "latency (us)   p50     p95     p99     max" << endl;
+    
+    auto addRow = [&](const char * name, const LatencyPercentiles & p){
+        ss << ofToString(name, 12, ' ') << ofToString(p.p50, 8, ' ') << ofToString(p.p95, 8, ' ') << ofToString(p.p99, 8, ' ') << ofToString(p.max, 8, ' ') << endl;
+    };
+    for (int i=0; i<NUM_LATENCY_STAGES; i++)
+        addRow(getLatencyStageName(i), frame.latency[i]);
+    addRow("display", displayPercentiles);
+    ss << "static frames skipped: " << pipeline.getSkippedFrames();
+    
+    ofDrawBitmapStringHighlight(ss.str(), 20, ofGetHeight() - 145);
 }
 
 //--------------------------------------------------------------
@@ -468,6 +502,15 @@ void ofApp::setupGUI(){
     paramsTouch.setName("3D Touch Parameters");
     paramsTouch.add(interactionZoneHeight.set("Zone Height", 50, 1, 500));
     paramsTouch.add(zOffset.set("z Offset", 0, -50, 50));
+    paramsTouch.add(touchHeight.set("Touch Height", 15, 1, 100));
+    paramsTouch.add(touchBirthFrames.set("Touch Birth Frames", 3, 1, 30));
+    paramsTouch.add(touchDeathFrames.set("Touch Death Frames", 5, 0, 30));
+    paramsTouch.add(touchMatchDistance.set("Touch Match Distance", 40, 5, 200));
+    paramsTouch.add(fingertipK.set("Fingertip K", 20, 3, 60));
+    paramsTouch.add(fingertipMaxAngle.set("Fingertip Max Angle", 60, 10, 120));
+    paramsTouch.add(sendTuio.set("Send TUIO", false));
+    paramsTouch.add(tuioPort.set("TUIO Port", 3333, 1024, 65535));
+    paramsTouch.add(shareTouches.set("Share Touches", false));
     
     interactionZoneHeight.addListener(this, &ofApp::updateInteractionZone);
     zOffset.addListener(this, &ofApp::updateZOffset);
@@ -477,7 +520,7 @@ void ofApp::setupGUI(){
     
     panelTouch.setup(paramsTouch);
     
-    panelTouch.setPosition(10, kinect.height + 20);
+    panelTouch.setPosition(10, source->getHeight() + 20);
     
     
     panelTouch.loadFromFile("settings_touch.xml");
@@ -485,6 +528,20 @@ void ofApp::setupGUI(){
     paramsCV.setName("CV Parameters");
     paramsCV.add(nearThreshold.set("Near Threshold", 255, 0, 255));
     paramsCV.add(farThreshold.set("Far Threshold", 234, 0, 255));
+    paramsCV.add(useRawDepth.set("Use Raw Depth", false));
+    paramsCV.add(nearThresholdMm.set("Near Depth mm", 500, 0, 4000));
+    paramsCV.add(farThresholdMm.set("Far Depth mm", 1000, 0, 4000));
+    paramsCV.add(useBackground.set("Use Background", false));
+    paramsCV.add(minHeightMm.set("Min Height mm", 10, 0, 200));
+    paramsCV.add(maxHeightMm.set("Max Height mm", 60, 0, 500));
+    paramsCV.add(backgroundFrames.set("Background Frames", 30, 1, 300));
+    paramsCV.add(usePlaneHeight.set("Use Plane Height", false));
+    paramsCV.add(useROI.set("Workspace ROI", true));
+    paramsCV.add(roiMargin.set("ROI Margin", 20, 0, 100));
+    paramsCV.add(tiledProcessing.set("Tiled Processing", false));
+    paramsCV.add(frameGate.set("Skip Static Frames", false));
+    paramsCV.add(gateNoiseMm.set("Static Noise mm", 8, 0, 50));
+    paramsCV.add(gateMinPixels.set("Static Min Pixels", 100, 16, 2000));
     paramsCV.add(minArea.set("Min Area", 1500, 0, 1500));
     paramsCV.add(maxArea.set("Max Area", 15000, 0, 50000));
     
@@ -494,27 +551,10 @@ void ofApp::setupGUI(){
     panelCV.loadFromFile("settings_cv.xml");
 }
 
-void ofApp::checkForTouch(){
-    
-    hasTouch = false;
-    touchIndices.clear();
-    for (int i=0; i< contourFinder.nBlobs; i++){
-        
-        if (workspacePlane2D.inside(contourFinder.blobs[i].centroid)){
-            hasTouch = true;
-            touchIndices.push_back(i);
-            
-        }
-        
-    }
-
-    
-}
-
-
 //--------------------------------------------------------------
 void ofApp::drawWorkspace(bool threeD) {
     
+    TRACE_SCOPE("drawWorkspace");
     if (threeD){
         ofPushStyle();
         ofPushMatrix();
@@ -560,6 +600,7 @@ void ofApp::drawWorkspace(bool threeD) {
 //--------------------------------------------------------------
 void ofApp::drawInteractionZone() {
     
+    TRACE_SCOPE("drawInteractionZone");
     ofPushStyle();
     ofPushMatrix();
     // the projected points are 'upside down' and 'backwards'
@@ -579,11 +620,12 @@ void ofApp::drawInteractionZone() {
     ofSetColor(255,255,0);
     ofDrawBox(baseCentroid, 20);
     
-    if (hasTouch){
+    TouchFrame & frame = pipeline.getFrame();
+    if (frame.hasTouch){
         ofFill();
-        for (auto &index : touchIndices){
-            ofPoint pt = contourFinder.blobs[index].centroid;
-            ofDrawBox(kinect.getWorldCoordinateAt(pt.x, pt.y), 10);
+        for (auto &index : frame.touchIndices){
+            ofPoint pt = frame.blobs[index].centroid;
+            ofDrawBox(pipeline.getWorldCoordinateAt(frame, pt.x, pt.y), 10);
         }
     }
     
@@ -594,29 +636,15 @@ void ofApp::drawInteractionZone() {
 
 //--------------------------------------------------------------
 void ofApp::drawPointCloud() {
-	int w = 640;
-	int h = 480;
-	ofMesh mesh;
-	mesh.setMode(OF_PRIMITIVE_POINTS);
-	int step = 2;
-	for(int y = 0; y < h; y += step) {
-		for(int x = 0; x < w; x += step) {
-			if(kinect.getDistanceAt(x, y) > 0) {
-				mesh.addColor(kinect.getColorAt(x,y));
-            
-                if (kinect.getWorldCoordinateAt(x, y).z < topCentroid.z &&
-                    kinect.getWorldCoordinateAt(x, y).z > btmCentroid.z)
-				mesh.addVertex(kinect.getWorldCoordinateAt(x, y));
-			}
-		}
-	}
+	TRACE_SCOPE("drawPointCloud");
+	// filled from the latest frame in update()
 	glPointSize(3);
 	ofPushMatrix();
 	// the projected points are 'upside down' and 'backwards' 
 	ofScale(1, -1, -1);
 	ofTranslate(0, 0, -1000); // center the points a bit
 	ofEnableDepthTest();
-	mesh.drawVertices();
+	pointCloud.draw();
 	ofDisableDepthTest();
 	ofPopMatrix();
 }
@@ -697,6 +725,8 @@ void ofApp::buildInteractionZone(){
     topCentroid = (interactionZone.getVertices()[4] + interactionZone.getVertices()[5] + interactionZone.getVertices()[6] + interactionZone.getVertices()[7])  /4;
     
     baseCentroid.set(btmCentroid.x, btmCentroid.y, btmCentroid.z);
+    
+    zone.setup(interactionZone.getVertices());
 }
 
 //--------------------------------------------------------------------------
@@ -726,7 +756,7 @@ void ofApp::updateInteractionZone(float &height){
         topCentroid = ( interactionZone.getVertices()[0] + interactionZone.getVertices()[1] + interactionZone.getVertices()[2] + interactionZone.getVertices()[3] ) /4;
         btmCentroid = (interactionZone.getVertices()[4] + interactionZone.getVertices()[5] + interactionZone.getVertices()[6] + interactionZone.getVertices()[7])  /4;
         
-        
+        zone.setup(interactionZone.getVertices());
     }
     
 }
@@ -747,7 +777,8 @@ void ofApp::updateZOffset(float &offset){
         btmCentroid = (interactionZone.getVertices()[4] + interactionZone.getVertices()[5] + interactionZone.getVertices()[6] + interactionZone.getVertices()[7])  /4;
         
         prevOffset=offset;
-
+        
+        zone.setup(interactionZone.getVertices());
     }
 
 }
@@ -781,8 +812,11 @@ void ofApp::calcNormals( ofMesh & mesh, bool bNormalize ){
 
 //--------------------------------------------------------------
 void ofApp::exit() {
-	kinect.setCameraTiltAngle(0); // zero the tilt on exit
-	kinect.close();
+	pipeline.stopRecording();
+	pipeline.waitForThread(true);
+	if (bTraceOnExit)
+		dumpTrace();
+	source->close();
     
     panelCV.saveToFile("settings_cv.xml");
     panelTouch.saveToFile("settings_touch.xml");
@@ -796,8 +830,6 @@ void ofApp::exit() {
 void ofApp::keyPressed (int key) {
 	switch (key) {
 		case ' ':
-			//bThreshWithOpenCV = !bThreshWithOpenCV;
-            
             bDrawProjector = !bDrawProjector;
             ofSetFullscreen(bDrawProjector);
             break;
@@ -808,23 +840,39 @@ void ofApp::keyPressed (int key) {
 			
 		case '>':
 		case '.':
+			if (useRawDepth) {
+				farThresholdMm = MIN(farThresholdMm + 5, 4000);
+				break;
+			}
 			farThreshold ++;
 			if (farThreshold > 255) farThreshold = 255;
 			break;
 			
 		case '<':
 		case ',':
+			if (useRawDepth) {
+				farThresholdMm = MAX(farThresholdMm - 5, 0);
+				break;
+			}
 			farThreshold --;
 			if (farThreshold < 0) farThreshold = 0;
 			break;
 			
 		case '+':
 		case '=':
+			if (useRawDepth) {
+				nearThresholdMm = MIN(nearThresholdMm + 5, 4000);
+				break;
+			}
 			nearThreshold ++;
 			if (nearThreshold > 255) nearThreshold = 255;
 			break;
 			
 		case '-':
+			if (useRawDepth) {
+				nearThresholdMm = MAX(nearThresholdMm - 5, 0);
+				break;
+			}
 			nearThreshold --;
 			if (nearThreshold < 0) nearThreshold = 0;
 			break;
@@ -834,8 +882,10 @@ void ofApp::keyPressed (int key) {
 //			break;
 			
 		case 'o':
-			kinect.setCameraTiltAngle(angle); // go back to prev tilt
-			kinect.open();
+			// only the sensor can be reopened, a replay is read by the processing thread
+			if (source != &kinectSource) break;
+			kinectSource.kinect.setCameraTiltAngle(angle); // go back to prev tilt
+			kinectSource.kinect.open();
 			break;
 			
         case 'w':
@@ -851,45 +901,66 @@ void ofApp::keyPressed (int key) {
 //			break;
 			
 		case '1':
-			kinect.setLed(ofxKinect::LED_GREEN);
+			kinectSource.kinect.setLed(ofxKinect::LED_GREEN);
 			break;
 			
 		case '2':
-			kinect.setLed(ofxKinect::LED_YELLOW);
+			kinectSource.kinect.setLed(ofxKinect::LED_YELLOW);
 			break;
 			
 		case '3':
-			kinect.setLed(ofxKinect::LED_RED);
+			kinectSource.kinect.setLed(ofxKinect::LED_RED);
 			break;
 			
 		case '4':
-			kinect.setLed(ofxKinect::LED_BLINK_GREEN);
+			kinectSource.kinect.setLed(ofxKinect::LED_BLINK_GREEN);
 			break;
 			
 		case '5':
-			kinect.setLed(ofxKinect::LED_BLINK_YELLOW_RED);
+			kinectSource.kinect.setLed(ofxKinect::LED_BLINK_YELLOW_RED);
 			break;
 			
 		case '0':
-			kinect.setLed(ofxKinect::LED_OFF);
+			kinectSource.kinect.setLed(ofxKinect::LED_OFF);
 			break;
 			
 		case OF_KEY_UP:
 			angle++;
 			if(angle>30) angle=30;
-			kinect.setCameraTiltAngle(angle);
+			kinectSource.kinect.setCameraTiltAngle(angle);
 			break;
 			
 		case OF_KEY_DOWN:
 			angle--;
 			if(angle<-30) angle=-30;
-			kinect.setCameraTiltAngle(angle);
+			kinectSource.kinect.setCameraTiltAngle(angle);
 			break;
+        case 'b':
+            // relearn the empty table
+            pipeline.learnBackground(backgroundFrames);
+            break;
+        case 'r':
+            // record the incoming frames for replay with --replay
+            if (pipeline.isRecording())
+                pipeline.stopRecording();
+            else
+                pipeline.startRecording("session_" + ofGetTimestampString() + ".k2td");
+            break;
+        case 'h':
+            bDrawHeight = !bDrawHeight;
+            break;
+        case 'l':
+            bDrawLatency = !bDrawLatency;
+            break;
+        case 't':
+            dumpTrace();
+            break;
         case 'c':
             workspace.clear();
             workspacePlane.clear();
             workspacePlane2D.clear();
             interactionZone.clear();
+            zone.clear();
             isWorkspaceDefined = false;
             break;
 	}
@@ -997,6 +1068,7 @@ void ofApp::mousePressed(int x, int y, int button)
     
     if (!isCalibrated){
         imagePoints.push_back(ofVec2f(mouseX,mouseY));
+        const ofVec3f & fingerPt = pipeline.getFrame().fingerPt;
         worldPoints.push_back(ofVec3f(fingerPt.x,fingerPt.y,fingerPt.z));
         calibCount++;
         
@@ -1004,19 +1076,9 @@ void ofApp::mousePressed(int x, int y, int button)
         if (calibCount == 40){
             
             
-            imagePts.open("imagePts.txt",ofFile::WriteOnly);
-            worldPts.open("worldPts.txt",ofFile::WriteOnly);
-            
-            for (int i=0; i<calibCount; i++){
-                
-                imagePts << ofToString(imagePoints[i].x) << ", " << ofToString(imagePoints[i].y) << endl;
-                
-                worldPts << ofToString(worldPoints[i].x) << ", " << ofToString(worldPoints[i].y) << ", " << ofToString(worldPoints[i].z) << endl;
-            
-            }
-
-            imagePts.close();
-            worldPts.close();
+            // the camera gets solved from these on the next launch
+            calibrationFile.setPoints(imagePoints, worldPoints);
+            calibrationFile.save(calibrationPath);
             
             isCalibrated = true;
             
@@ -1037,7 +1099,7 @@ void ofApp::mouseReleased(int x, int y, int button)
 
     if (!isWorkspaceDefined && isCalibrated){
         
-        workspace.push_back(kinect.getWorldCoordinateAt(x-10, y-10));
+        workspace.push_back(pipeline.getWorldCoordinateAt(pipeline.getFrame(), x-10, y-10));
         
         workspacePlane.addVertex(workspace.back());
         workspacePlane2D.addVertex(ofVec3f(x-10,y-10,0));
@@ -1072,65 +1134,36 @@ void ofApp::windowResized(int w, int h)
 
 }
 
-void ofApp::readCalibrationFiles(string image, string world){
+bool ofApp::loadCalibration(){
     
-    imagePoints.clear();
-    worldPoints.clear();
-   
-    // process the images points first
-    ofBuffer buffer = ofBufferFromFile(image);
+    TRACE_SCOPE("loadCalibration");
     
-    if(buffer.size()) {
-        
-        for (ofBuffer::Line it = buffer.getLines().begin(), end = buffer.getLines().end(); it != end; ++it) {
-            
-            string line = *it;
-            
-            // copy the line to draw later
-            // make sure its not a empty line
-            if(line.empty() == false) {
-                
-                float x = ofToFloat(ofSplitString(line, ", ")[0]);
-                float y = ofToFloat(ofSplitString(line, ", ")[1]);
-                
-                imagePoints.push_back(ofVec2f(x,y));
-
-                // print out the line
-                cout << "image point: " << line << endl;
-            }
-            
-            
-        }
-        
+    // convert the old text files the first time round
+    if (!calibrationFile.load(calibrationPath)){
+        if (!calibrationFile.loadText("imagePts.txt", "worldPts.txt"))
+            return false;
+        calibrationFile.save(calibrationPath);
     }
     
-    // the process the world points
-    buffer = ofBufferFromFile(world);
+    calibrationFile.getPoints(imagePoints, worldPoints);
+    calibration.loadPoints(imagePoints, worldPoints);
+    isCalibrated = true;
     
-    if(buffer.size()) {
-        
-        for (ofBuffer::Line it = buffer.getLines().begin(), end = buffer.getLines().end(); it != end; ++it) {
-            
-            string line = *it;
-            
-            // copy the line to draw later
-            // make sure its not a empty line
-            if(line.empty() == false) {
-                
-                float x = ofToFloat(ofSplitString(line, ", ")[0]);
-                float y = ofToFloat(ofSplitString(line, ", ")[1]);
-                float z = ofToFloat(ofSplitString(line, ", ")[2]);
-                
-                worldPoints.push_back(ofVec3f(x,y,z));
-
-                // print out the line
-                cout << "world point: " << line << endl;
-            }
-            
-            
-        }
-        
+    // only solve when the file doesn't already have the camera
+    if (!calibration.loadSolution(calibrationFile)){
+        calibration.correctCamera();
+        calibration.saveSolution(calibrationFile);
+        calibrationFile.save(calibrationPath);
     }
     
-    isCalibrated = true;
+    return true;
+}
+
+//--------------------------------------------------------------
+void ofApp::dumpTrace(){
+#if KINECT2TOUCH_TRACE
+    Trace::dump("trace_" + ofGetTimestampString() + ".json", traceSeconds);
+#else
+    ofLogWarning("ofApp") << "built with KINECT2TOUCH_TRACE=0, nothing to dump";
+#endif
 }
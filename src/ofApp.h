@@ -3,10 +3,16 @@
 #include "ofMain.h"
 #include "ofxOpenCv.h"
 #include "ofxKinect.h"
+#include "KinectDepthSource.h"
+#include "ReplayDepthSource.h"
+#include "TouchPipeline.h"
+#include "PointCloudRenderer.h"
+#include "WorkerPool.h"
 #include "ofxGui.h"
-#include "ofxConvexHull.h"
 #include "ofxXmlSettings.h"
 #include "CalibrateCoords.h"
+#include "CalibrationFile.h"
+#include "Trace.h"
 
 // Windows users:
 // You MUST install the libfreenect kinect drivers in order to be able to use
@@ -41,6 +47,9 @@ public:
     void setupGUI();
 	
 	void drawPointCloud();
+	PointCloudRenderer pointCloud;
+	
+	WorkerPool workers; // shared by everything that splits work across cores
 	
 	void keyPressed(int key);
 	void mouseDragged(int x, int y, int button);
@@ -50,7 +59,39 @@ public:
 	void mouseExited(int x, int y);
 	void windowResized(int w, int h);
 	
-	ofxKinect kinect;
+	KinectDepthSource kinectSource;
+	ReplayDepthSource replaySource;
+	DepthSource * source; // where frames come from: the live kinect or a replay
+	
+	// set from the command line to run from a recording instead of the sensor
+	string replayPath;
+	bool bReplayFast = false;
+	
+	// 't' writes the last traceSeconds of trace markers to a Chrome trace file,
+	// --trace <seconds> also writes one on exit (see Trace.h)
+	float traceSeconds = 10;
+	bool bTraceOnExit = false;
+	void dumpTrace();
+	
+	// depth processing runs on its own thread, draw() reads its latest result
+	TouchPipeline pipeline;
+	TouchSettings touchSettings;
+	void updateTouchSettings();
+	
+	ofTexture depthTexture;
+	ofTexture colorTexture;
+	ofTexture threshTexture;
+	
+	// 'h' shows the height above the workspace in place of the thresholded image
+	bool bDrawHeight = false;
+	ofPixels heightPixels;
+	
+	// 'l' shows the per-stage latency percentiles; display is frame published to picked up here
+	bool bDrawLatency = false;
+	LatencyHistogram displayLatency;
+	LatencyPercentiles displayPercentiles;
+	uint64_t displayWindowStart = 0;
+	void drawLatency(const TouchFrame & frame);
 	
 #ifdef USE_TWO_KINECTS
 	ofxKinect kinect2;
@@ -58,20 +99,24 @@ public:
 	
 	ofxCvColorImage colorImg;
 	
-	ofxCvGrayscaleImage grayImage; // grayscale depth image
-	ofxCvGrayscaleImage grayThreshNear; // the near thresholded image
-	ofxCvGrayscaleImage grayThreshFar; // the far thresholded image
-	
-	ofxCvContourFinder contourFinder;
-    ofxConvexHull convexHull;
-//    vector<ofPoint> points;
-    vector<ofPoint> hull;
-	
-	bool bThreshWithOpenCV;
 	bool bDrawPointCloud;
 	
 	ofParameter<int> nearThreshold;
 	ofParameter<int> farThreshold;
+	ofParameter<bool> useRawDepth;
+	ofParameter<int> nearThresholdMm;
+	ofParameter<int> farThresholdMm;
+	ofParameter<bool> useBackground;
+	ofParameter<int> minHeightMm;
+	ofParameter<int> maxHeightMm;
+	ofParameter<int> backgroundFrames;
+	ofParameter<bool> usePlaneHeight;
+	ofParameter<bool> useROI;
+	ofParameter<int> roiMargin;
+	ofParameter<bool> tiledProcessing;
+	ofParameter<bool> frameGate;
+	ofParameter<int> gateNoiseMm;
+	ofParameter<int> gateMinPixels;
     ofParameter<int> minArea;
     ofParameter<int> maxArea;
 	
@@ -106,39 +151,48 @@ public:
     void updateZOffset(float &offset);
     float prevOffset;
     
+    // touch tracking
+    ofParameter<int> touchBirthFrames;
+    ofParameter<int> touchDeathFrames;
+    ofParameter<float> touchMatchDistance;
+    ofParameter<int> fingertipK;
+    ofParameter<float> fingertipMaxAngle;
+    
+    // touch output
+    ofParameter<bool> sendTuio;
+    ofParameter<int> tuioPort;
+    ofParameter<bool> shareTouches;
+    
     ofVec3f topCentroid;
     ofVec3f btmCentroid;
     
+    // the zone as planes, for the touch test; rebuilt whenever the zone changes
+    InteractionZone zone;
+    ofParameter<float> touchHeight;
+    
     ////////////////////////////////////////////////
     
     ////////////////////////////////////////////////
     ///////////////////// TOUCH ////////////////////
 
-    bool hasTouch = false;
-    vector<int> touchIndices;
-    
-    void checkForTouch();
-    
-    
     CalibrateCoords calibration;
     bool useCalibrated = false;
     bool isCalibrated = false;
-    ofVec3f fingerPt;
-    ofVec3f fingerPt2D;
     int calibCount = 0;
     
     vector<ofVec2f> imagePoints;
     vector<ofVec3f> worldPoints;
     
-    ofFile imagePts;
-    ofFile worldPts;
+    // calibration points and the solved camera, see CalibrationFile.h
+    CalibrationFile calibrationFile;
+    string calibrationPath = "calibration.k2tc";
     
     ////////////////////////////////////////////////
     
     
     bool bDrawProjector = false;
 
-    void readCalibrationFiles(string image, string world);
+    bool loadCalibration();
     
     // fake-ass mapping
     